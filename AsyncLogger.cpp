@@ -0,0 +1,360 @@
+#include "AsyncLogger.h"
+#include "Metrics.h"
+#include <QDateTime>
+#include <QLoggingCategory>
+#include <QThread>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+AsyncLogger::Level levelFromType(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:    return AsyncLogger::Level::Debug;
+    case QtInfoMsg:     return AsyncLogger::Level::Info;
+    case QtWarningMsg:  return AsyncLogger::Level::Warning;
+    case QtCriticalMsg: return AsyncLogger::Level::Critical;
+    case QtFatalMsg:    return AsyncLogger::Level::Fatal;
+    }
+    return AsyncLogger::Level::Debug;
+}
+
+const char* levelTag(AsyncLogger::Level level)
+{
+    switch (level) {
+    case AsyncLogger::Level::Debug:    return " D ";
+    case AsyncLogger::Level::Info:     return " I ";
+    case AsyncLogger::Level::Warning:  return " W ";
+    case AsyncLogger::Level::Critical: return " C ";
+    case AsyncLogger::Level::Fatal:    return " F ";
+    }
+    return " ? ";
+}
+
+// 写线程批量写出的缓冲区大小
+const int kWriteBatchBytes = 64 * 1024;
+}
+
+AsyncLogger& AsyncLogger::instance()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+}
+
+AsyncLogger::Level AsyncLogger::levelFromString(const QString& name, Level fallback)
+{
+    const QString value = name.trimmed().toLower();
+    if (value == "debug") return Level::Debug;
+    if (value == "info") return Level::Info;
+    if (value == "warning" || value == "warn") return Level::Warning;
+    if (value == "critical" || value == "error") return Level::Critical;
+    return fallback;
+}
+
+void AsyncLogger::setMinLevel(Level level)
+{
+    m_minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+
+    // 默认类别按级别关闭，被过滤的消息在Qt内部就被丢弃，不再进入处理器
+    QString rules;
+    if (level > Level::Debug) rules += "*.debug=false\n";
+    if (level > Level::Info) rules += "*.info=false\n";
+    if (level > Level::Warning) rules += "*.warning=false\n";
+    QLoggingCategory::setFilterRules(rules);
+}
+
+void AsyncLogger::start(const Options& options)
+{
+    if (m_running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // 容量取2的幂，下标用掩码计算
+    size_t capacity = 2;
+    while (capacity < static_cast<size_t>(qMax(2, options.capacity))) {
+        capacity <<= 1;
+    }
+    m_slots.reset(new Slot[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_mask = capacity - 1;
+    m_enqueuePos.store(0, std::memory_order_relaxed);
+    m_dequeuePos = 0;
+
+    m_maxLinesPerSecond = options.maxLinesPerSecond;
+    m_writeToStderr = options.writeToStderr;
+
+    Level level = options.minLevel;
+    const QByteArray envLevel = qgetenv("AR_LOG_LEVEL");
+    if (!envLevel.isEmpty()) {
+        level = levelFromString(QString::fromLatin1(envLevel), level);
+    }
+    setMinLevel(level);
+
+    QString filePath = options.filePath;
+    const QByteArray envFile = qgetenv("AR_LOG_FILE");
+    if (!envFile.isEmpty()) {
+        filePath = QString::fromLocal8Bit(envFile);
+    }
+    if (!filePath.isEmpty()) {
+        m_file = std::fopen(filePath.toLocal8Bit().constData(), "ab");
+        if (!m_file) {
+            std::fprintf(stderr, "无法打开日志文件: %s\n", filePath.toLocal8Bit().constData());
+        }
+    }
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_droppedMetric = registry.counter("log_messages_dropped_total", "Log messages dropped because the ring buffer was full");
+    m_suppressedMetric = registry.counter("log_messages_suppressed_total", "Debug/info log messages dropped by the rate limit");
+
+    m_running.store(true, std::memory_order_release);
+    m_writer = std::thread([this]() { writerLoop(); });
+    m_previousHandler = qInstallMessageHandler(&AsyncLogger::messageHandler);
+}
+
+void AsyncLogger::stop()
+{
+    if (!m_running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    qInstallMessageHandler(m_previousHandler);
+    m_previousHandler = nullptr;
+
+    m_running.store(false, std::memory_order_release);
+    m_wakeCondition.notify_one();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    instance().log(type, context, message);
+}
+
+void AsyncLogger::log(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    Level level = levelFromType(type);
+    if (level < minLevel()) {
+        return;
+    }
+
+    Record record;
+    record.level = level;
+    record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+    if (level <= Level::Info && !acquireRateToken()) {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        m_suppressedMetric->inc();
+        return;
+    }
+
+    record.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    record.category = context.category;
+    record.file = context.file;
+    record.line = context.line;
+    record.message = message.toUtf8();
+
+    if (!tryPush(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_droppedMetric->inc();
+        if (level >= Level::Critical) {
+            // 严重错误不能丢，缓冲区满时直接写stderr
+            const QByteArray text = message.toUtf8();
+            std::fprintf(stderr, "%s\n", text.constData());
+        }
+        return;
+    }
+    m_accepted.fetch_add(1, std::memory_order_release);
+
+    if (m_writerSleeping.load(std::memory_order_acquire)) {
+        m_wakeCondition.notify_one();
+    }
+
+    if (type == QtFatalMsg) {
+        // 返回后Qt将终止进程，先等写线程把日志写出
+        flush(2000);
+    }
+}
+
+bool AsyncLogger::acquireRateToken()
+{
+    if (m_maxLinesPerSecond <= 0) {
+        return true;
+    }
+
+    const qint64 second = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    qint64 window = m_rateWindow.load(std::memory_order_relaxed);
+    if (window != second && m_rateWindow.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+        // 进入新的一秒，只有切换窗口的线程负责清零
+        m_rateCount.store(0, std::memory_order_relaxed);
+    }
+    return m_rateCount.fetch_add(1, std::memory_order_relaxed) < m_maxLinesPerSecond;
+}
+
+bool AsyncLogger::tryPush(Record&& record)
+{
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[pos & m_mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            // 槽位空闲，抢占写入位置
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = std::move(record);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // 写线程还没取走一整圈之前的消息：缓冲区已满
+            return false;
+        } else {
+            // 被其他生产方抢先，重新读取写入位置
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AsyncLogger::tryPop(Record& record)
+{
+    Slot& slot = m_slots[m_dequeuePos & m_mask];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(m_dequeuePos + 1) < 0) {
+        return false;
+    }
+
+    record = std::move(slot.record);
+    slot.record.message = QByteArray();
+    // 槽位交还给下一圈的生产方
+    slot.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+    ++m_dequeuePos;
+    return true;
+}
+
+void AsyncLogger::formatRecord(const Record& record, QByteArray& out) const
+{
+    out.append(QDateTime::fromMSecsSinceEpoch(record.timestampMs)
+                   .toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1());
+    out.append(levelTag(record.level));
+    out.append('[');
+    out.append(QByteArray::number(static_cast<qulonglong>(record.threadId), 16));
+    out.append("] ", 2);
+    if (record.category && std::strcmp(record.category, "default") != 0) {
+        out.append(record.category);
+        out.append(": ", 2);
+    }
+    out.append(record.message);
+    if (record.file && record.level >= Level::Warning) {
+        out.append(" (", 2);
+        out.append(record.file);
+        out.append(':');
+        out.append(QByteArray::number(record.line));
+        out.append(')');
+    }
+    out.append('\n');
+}
+
+void AsyncLogger::writeOut(const QByteArray& data)
+{
+    if (m_writeToStderr) {
+        std::fwrite(data.constData(), 1, static_cast<size_t>(data.size()), stderr);
+        std::fflush(stderr);
+    }
+    if (m_file) {
+        std::fwrite(data.constData(), 1, static_cast<size_t>(data.size()), m_file);
+        std::fflush(m_file);
+    }
+}
+
+void AsyncLogger::writerLoop()
+{
+    QByteArray batch;
+    batch.reserve(kWriteBatchBytes * 2);
+    Record record;
+
+    quint64 reportedDropped = 0;
+    quint64 reportedSuppressed = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+
+    for (;;) {
+        // 先读取停止标志再取数据：停止后的最后一轮会把缓冲区取空
+        bool running = m_running.load(std::memory_order_acquire);
+
+        quint64 count = 0;
+        while (tryPop(record)) {
+            formatRecord(record, batch);
+            ++count;
+            if (batch.size() >= kWriteBatchBytes) {
+                writeOut(batch);
+                batch.resize(0);
+            }
+        }
+
+        // 丢弃的日志每秒汇总一次，避免静默丢失
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(1) || !running) {
+            quint64 dropped = droppedCount();
+            quint64 suppressed = suppressedCount();
+            if (dropped != reportedDropped || suppressed != reportedSuppressed) {
+                batch.append(QString("%1 W [logger] 日志限速丢弃 %2 条，缓冲区满丢弃 %3 条\n")
+                                 .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                                 .arg(suppressed - reportedSuppressed)
+                                 .arg(dropped - reportedDropped)
+                                 .toUtf8());
+                reportedDropped = dropped;
+                reportedSuppressed = suppressed;
+            }
+            lastReport = now;
+        }
+
+        if (!batch.isEmpty()) {
+            writeOut(batch);
+            batch.resize(0);
+        }
+        if (count > 0) {
+            m_written.fetch_add(count, std::memory_order_release);
+            continue;
+        }
+
+        if (!running) {
+            break;
+        }
+
+        // 没有日志时等待唤醒；超时兜底，生产方错过唤醒时最多延迟一个周期
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_writerSleeping.store(true, std::memory_order_seq_cst);
+        m_wakeCondition.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+            const Slot& slot = m_slots[m_dequeuePos & m_mask];
+            return !m_running.load(std::memory_order_acquire)
+                || slot.sequence.load(std::memory_order_acquire) == m_dequeuePos + 1;
+        });
+        m_writerSleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::flush(int timeoutMs)
+{
+    const quint64 target = m_accepted.load(std::memory_order_acquire);
+    m_wakeCondition.notify_one();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (m_written.load(std::memory_order_acquire) < target
+           && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class MetricCounter;
+
+// 异步日志：安装为Qt消息处理器，qDebug/qInfo/qWarning等调用只把消息放入无锁环形缓冲区，
+// 格式化输出和写文件由后台线程完成，调用线程（帧处理、HTTP工作线程）不再等待终端或磁盘I/O。
+// 过滤分两级：编译期由CMake选项AR_LOG_COMPILE_LEVEL定义QT_NO_DEBUG_OUTPUT/QT_NO_INFO_OUTPUT，
+// 运行期按最低级别过滤（同时设置默认日志类别的过滤规则，被过滤的消息不会到达处理器）
+class AsyncLogger
+{
+public:
+    enum class Level {
+        Debug = 0,
+        Info,
+        Warning,
+        Critical,
+        Fatal
+    };
+
+    struct Options {
+        // 运行期最低输出级别
+        Level minLevel = Level::Debug;
+        // 环形缓冲区容量（向上取整为2的幂），满时丢弃新消息并计数，不阻塞调用线程
+        int capacity = 8192;
+        // Debug/Info每秒最多接收的条数，超出部分计数后丢弃；<=0表示不限制。Warning及以上不受限制
+        int maxLinesPerSecond = 2000;
+        // 为空时只输出到stderr
+        QString filePath;
+        bool writeToStderr = true;
+    };
+
+    static AsyncLogger& instance();
+
+    // 启动写线程并安装消息处理器；可由环境变量AR_LOG_LEVEL、AR_LOG_FILE覆盖级别和文件
+    void start(const Options& options);
+    // 写出缓冲区中剩余的日志，停止写线程并恢复原消息处理器
+    void stop();
+
+    void setMinLevel(Level level);
+    Level minLevel() const { return static_cast<Level>(m_minLevel.load(std::memory_order_relaxed)); }
+
+    // "debug"/"info"/"warning"/"critical"，无法识别时返回fallback
+    static Level levelFromString(const QString& name, Level fallback);
+
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    quint64 suppressedCount() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+private:
+    AsyncLogger() = default;
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    struct Record {
+        Level level = Level::Debug;
+        qint64 timestampMs = 0;
+        quintptr threadId = 0;
+        // 指向字符串字面量（__FILE__、日志类别名），生命周期足够长
+        const char* category = nullptr;
+        const char* file = nullptr;
+        int line = 0;
+        QByteArray message;
+    };
+
+    // 有界MPSC队列的槽位：sequence表示该槽位当前可写（== 位置）或可读（== 位置+1）
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message);
+    void log(QtMsgType type, const QMessageLogContext& context, const QString& message);
+
+    // 生产方（任意线程）：无锁入队，缓冲区满时返回false
+    bool tryPush(Record&& record);
+    // 消费方（仅写线程）
+    bool tryPop(Record& record);
+    // Debug/Info限速，返回false表示本条应丢弃
+    bool acquireRateToken();
+
+    void writerLoop();
+    void formatRecord(const Record& record, QByteArray& out) const;
+    void writeOut(const QByteArray& data);
+    // 等待写线程写完此前入队的日志（Fatal消息在进程终止前调用）
+    void flush(int timeoutMs);
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    // 生产方竞争的写入位置与写线程独占的读取位置分在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) size_t m_dequeuePos = 0;
+
+    std::atomic<int> m_minLevel{static_cast<int>(Level::Debug)};
+    int m_maxLinesPerSecond = 0;
+    std::atomic<qint64> m_rateWindow{0};
+    std::atomic<int> m_rateCount{0};
+
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_suppressed{0};
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_accepted{0};
+    MetricCounter* m_droppedMetric = nullptr;
+    MetricCounter* m_suppressedMetric = nullptr;
+
+    std::atomic<bool> m_running{false};
+    // 写线程空闲等待时为true，生产方只在此时唤醒它，避免每条日志一次系统调用
+    std::atomic<bool> m_writerSleeping{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    std::thread m_writer;
+
+    bool m_writeToStderr = true;
+    FILE* m_file = nullptr;
+    QtMessageHandler m_previousHandler = nullptr;
+};
+
+#endif // ASYNCLOGGER_H
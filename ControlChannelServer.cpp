@@ -0,0 +1,273 @@
+#include "ControlChannelServer.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QDebug>
+#include "Metrics.h"
+
+namespace {
+// 命令都很短，超长消息直接拒绝
+const qint64 kMaxMessageSize = 4 * 1024;
+
+struct ControlMetrics {
+    MetricHistogram* latency;
+    MetricCounter* commands;
+    MetricCounter* errors;
+    MetricGauge* clients;
+};
+
+const ControlMetrics& controlMetrics()
+{
+    static const ControlMetrics metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        return ControlMetrics{
+            registry.histogram("control_command_duration_seconds",
+                               "WebSocket control command time from receipt to acknowledgement"),
+            registry.counter("control_commands_total", "WebSocket control commands received"),
+            registry.counter("control_command_errors_total", "WebSocket control commands rejected"),
+            registry.gauge("control_clients", "Connected WebSocket control clients"),
+        };
+    }();
+    return metrics;
+}
+}
+
+ControlChannelServer::ControlChannelServer(RequestHandler* requestHandler, QObject* parent)
+    : QObject(parent),
+      m_requestHandler(requestHandler)
+{
+}
+
+ControlChannelServer::~ControlChannelServer()
+{
+    stop();
+}
+
+#if QT_CONFIG(ssl)
+void ControlChannelServer::setSslConfiguration(const QSslConfiguration& configuration)
+{
+    m_sslConfiguration = configuration;
+    m_secure = !configuration.isNull();
+}
+#endif
+
+bool ControlChannelServer::start(quint16 port)
+{
+    if (m_server) {
+        return m_server->isListening();
+    }
+
+    m_server = new QWebSocketServer("AR Control", m_secure ? QWebSocketServer::SecureMode
+                                                           : QWebSocketServer::NonSecureMode, this);
+#if QT_CONFIG(ssl)
+    if (m_secure) {
+        m_server->setSslConfiguration(m_sslConfiguration);
+    }
+#endif
+    connect(m_server, &QWebSocketServer::newConnection, this, &ControlChannelServer::onNewConnection);
+
+    if (!m_server->listen(QHostAddress::Any, port)) {
+        qWarning() << "控制通道启动失败:" << m_server->errorString();
+        return false;
+    }
+    qDebug() << "控制通道已启动，端口:" << port << (m_secure ? "(wss)" : "(ws)");
+    return true;
+}
+
+void ControlChannelServer::stop()
+{
+    for (QWebSocket* client : m_clients) {
+        client->disconnect(this);
+        client->close();
+        client->deleteLater();
+    }
+    controlMetrics().clients->add(-m_clients.size());
+    m_clients.clear();
+
+    if (m_server) {
+        m_server->close();
+        m_server->deleteLater();
+        m_server = nullptr;
+    }
+}
+
+void ControlChannelServer::onNewConnection()
+{
+    while (QWebSocket* client = m_server->nextPendingConnection()) {
+        if (m_clients.size() >= m_maxClients) {
+            qWarning() << "控制通道客户端数超过上限，拒绝:" << client->peerAddress().toString();
+            client->close(QWebSocketProtocol::CloseCodeTooMuchData, "Too many clients");
+            client->deleteLater();
+            continue;
+        }
+
+        client->setMaxAllowedIncomingMessageSize(kMaxMessageSize);
+        connect(client, &QWebSocket::textMessageReceived, this, &ControlChannelServer::onTextMessage);
+        connect(client, &QWebSocket::disconnected, this, &ControlChannelServer::onDisconnected);
+        m_clients.append(client);
+        controlMetrics().clients->add(1);
+
+        qDebug() << "控制通道客户端已连接:" << client->peerAddress().toString()
+                 << "当前客户端数:" << m_clients.size();
+    }
+}
+
+void ControlChannelServer::onDisconnected()
+{
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    if (!client || !m_clients.removeOne(client)) {
+        return;
+    }
+    controlMetrics().clients->add(-1);
+    qDebug() << "控制通道客户端已断开:" << client->peerAddress().toString();
+    client->deleteLater();
+}
+
+void ControlChannelServer::onTextMessage(const QString& message)
+{
+    QElapsedTimer received;
+    received.start();
+
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    if (!client) {
+        return;
+    }
+    controlMetrics().commands->inc();
+
+    Command command;
+    QString error;
+    if (!parseCommand(message, command, error)) {
+        controlMetrics().errors->inc();
+        sendError(client, command.id, error);
+        return;
+    }
+    dispatch(client, command, received);
+}
+
+bool ControlChannelServer::parseCommand(const QString& message, Command& command, QString& error)
+{
+    const QString text = message.trimmed();
+
+    if (text.startsWith('{')) {
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8(), &parseError);
+        if (!doc.isObject()) {
+            error = "Invalid JSON";
+            return false;
+        }
+        const QJsonObject obj = doc.object();
+        command.id = obj.value("id");
+        command.name = obj.value("cmd").toString().toLower();
+        command.action = obj.value("action").toString().toLower();
+        command.pageIndex = obj.value("index").toInt(-1);
+    } else {
+        // 单词形式，便于遥控器等简单客户端
+        const QStringList parts = text.split(' ', Qt::SkipEmptyParts);
+        const QString word = parts.value(0).toLower();
+        if (word == "next" || word == "n") {
+            command.name = "pdf";
+            command.action = "next";
+        } else if (word == "prev" || word == "p") {
+            command.name = "pdf";
+            command.action = "prev";
+        } else if (word == "back" || word == "b") {
+            command.name = "back";
+        } else if (word == "page") {
+            command.name = "page";
+            bool ok = false;
+            command.pageIndex = parts.value(1).toInt(&ok);
+            if (!ok) {
+                command.pageIndex = -1;
+            }
+        } else {
+            command.name = word;
+        }
+    }
+
+    if (command.name == "pdf") {
+        if (command.action != "next" && command.action != "prev") {
+            error = "Invalid action parameter";
+            return false;
+        }
+    } else if (command.name == "page") {
+        if (command.pageIndex < 0) {
+            error = "Invalid page index";
+            return false;
+        }
+    } else if (command.name != "back" && command.name != "state" && command.name != "ping") {
+        error = "Unknown command";
+        return false;
+    }
+    return true;
+}
+
+void ControlChannelServer::dispatch(QWebSocket* client, const Command& command, const QElapsedTimer& received)
+{
+    if (command.name == "ping") {
+        sendAck(client, command, QJsonObject(), received);
+        return;
+    }
+
+    // 与HTTP接口发出相同的信号（MainWindow/PDFViewerPage以排队方式接收，事件流直接接收）
+    if (command.name == "pdf") {
+        if (command.action == "next") {
+            emit m_requestHandler->pdfNextPage();
+        } else {
+            emit m_requestHandler->pdfPrevPage();
+        }
+    } else if (command.name == "page") {
+        emit m_requestHandler->switchPageRequested(command.pageIndex);
+    } else if (command.name == "back") {
+        emit m_requestHandler->backToMainRequested();
+    }
+
+    // 同一线程的排队事件按投递顺序处理：这里投递到界面线程的调用在上面的槽执行之后才运行，
+    // 取到的就是命令生效后的状态
+    QPointer<ControlChannelServer> self(this);
+    QPointer<QWebSocket> target(client);
+    RequestHandler* requestHandler = m_requestHandler;
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [self, target, requestHandler, command, received]() {
+        const QJsonObject state = requestHandler->uiState();
+        if (!self) {
+            return;
+        }
+        QMetaObject::invokeMethod(self.data(), [self, target, command, state, received]() {
+            if (self && target) {
+                self->sendAck(target.data(), command, state, received);
+            }
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void ControlChannelServer::sendAck(QWebSocket* client, const Command& command, const QJsonObject& state,
+                                   const QElapsedTimer& received)
+{
+    const qint64 elapsedNs = received.nsecsElapsed();
+    controlMetrics().latency->observeNanoseconds(elapsedNs);
+
+    QJsonObject ack;
+    if (!command.id.isUndefined() && !command.id.isNull()) {
+        ack["id"] = command.id;
+    }
+    ack["ok"] = true;
+    ack["cmd"] = command.name;
+    if (!command.action.isEmpty()) {
+        ack["action"] = command.action;
+    }
+    if (!state.isEmpty()) {
+        ack["state"] = state;
+    }
+    ack["us"] = elapsedNs / 1000;
+    client->sendTextMessage(QString::fromUtf8(QJsonDocument(ack).toJson(QJsonDocument::Compact)));
+}
+
+void ControlChannelServer::sendError(QWebSocket* client, const QJsonValue& id, const QString& error)
+{
+    QJsonObject reply;
+    if (!id.isUndefined() && !id.isNull()) {
+        reply["id"] = id;
+    }
+    reply["ok"] = false;
+    reply["error"] = error;
+    client->sendTextMessage(QString::fromUtf8(QJsonDocument(reply).toJson(QJsonDocument::Compact)));
+}
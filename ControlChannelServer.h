@@ -0,0 +1,76 @@
+#ifndef CONTROLCHANNELSERVER_H
+#define CONTROLCHANNELSERVER_H
+
+#include <QObject>
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QJsonObject>
+#include <QList>
+#include <QElapsedTimer>
+#include "Requesthandler.h"
+
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+// 持久的WebSocket控制通道：遥控器和手机应用在一个连接上连续发送翻页、切换页面命令，
+// 不再每次点击都新建HTTP连接。命令映射到RequestHandler已有的信号
+// （switchPageRequested/backToMainRequested/pdfNextPage/pdfPrevPage），
+// 界面处理完之后回复带有最新界面状态的确认。
+//
+// 命令可以是单词形式："next"/"n"、"prev"/"p"、"back"/"b"、"page 2"、"state"、"ping"，
+// 也可以是JSON：{"id":7,"cmd":"pdf","action":"next"}、{"id":8,"cmd":"page","index":2}。
+// 确认：{"id":7,"ok":true,"cmd":"pdf","state":{...},"us":850}，us为收到命令到发出确认的微秒数
+class ControlChannelServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ControlChannelServer(RequestHandler* requestHandler, QObject* parent = nullptr);
+    ~ControlChannelServer();
+
+#if QT_CONFIG(ssl)
+    // 设置后以wss://提供服务（需在start()之前调用）
+    void setSslConfiguration(const QSslConfiguration& configuration);
+#endif
+
+    // 最多同时保持的客户端数
+    void setMaxClients(int count) { m_maxClients = qMax(1, count); }
+
+public slots:
+    // 在本对象所在线程调用
+    bool start(quint16 port);
+    void stop();
+
+private slots:
+    void onNewConnection();
+    void onTextMessage(const QString& message);
+    void onDisconnected();
+
+private:
+    struct Command {
+        QJsonValue id;
+        QString name;      // "pdf" / "page" / "back" / "state" / "ping"
+        QString action;    // pdf: "next" / "prev"
+        int pageIndex = -1;
+    };
+
+    RequestHandler* m_requestHandler;
+    QWebSocketServer* m_server = nullptr;
+    QList<QWebSocket*> m_clients;
+    int m_maxClients = 16;
+    bool m_secure = false;
+#if QT_CONFIG(ssl)
+    QSslConfiguration m_sslConfiguration;
+#endif
+
+    // 解析单词或JSON形式的命令，失败时返回false并填写error
+    static bool parseCommand(const QString& message, Command& command, QString& error);
+
+    // 发出对应信号；界面线程处理完信号后取得状态，再回到本线程发送确认
+    void dispatch(QWebSocket* client, const Command& command, const QElapsedTimer& received);
+    void sendAck(QWebSocket* client, const Command& command, const QJsonObject& state,
+                 const QElapsedTimer& received);
+    static void sendError(QWebSocket* client, const QJsonValue& id, const QString& error);
+};
+
+#endif // CONTROLCHANNELSERVER_H
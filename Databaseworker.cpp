@@ -8,7 +8,33 @@
 #include <QMutexLocker>     // 互斥锁
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QThread>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringList>
+#include "Metrics.h"
+#include "RequestTracer.h"
 
+namespace {
+struct QueryMetrics {
+    MetricHistogram* duration;
+    MetricCounter* total;
+    MetricCounter* errors;
+};
+
+const QueryMetrics& queryMetrics()
+{
+    static const QueryMetrics metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        return QueryMetrics{
+            registry.histogram("db_query_duration_seconds", "DatabaseWorker::queryData time including row fetch"),
+            registry.counter("db_queries_total", "Queries executed through DatabaseWorker"),
+            registry.counter("db_query_errors_total", "Queries that failed to execute"),
+        };
+    }();
+    return metrics;
+}
+}
 
 DatabaseWorker::DatabaseWorker(QObject *parent) : QObject(parent) {}
 
@@ -19,6 +45,7 @@ bool DatabaseWorker::connect(const QString &host, int port,
     QString connName = QString("connection_%1")
                        .arg(QRandomGenerator::global()->generate(), 0, 16);
     
+    m_connectionName = connName;
     m_db = QSqlDatabase::addDatabase("QMYSQL", connName);
     m_db.setHostName(host);
     m_db.setPort(port);
@@ -33,15 +60,68 @@ bool DatabaseWorker::connect(const QString &host, int port,
     return true;
 }
 
-QJsonArray DatabaseWorker::queryData(const QString &sql) {
+bool DatabaseWorker::connectSqlite(const QString &filePath) {
+    QString connName = QString("connection_%1")
+                       .arg(QRandomGenerator::global()->generate(), 0, 16);
+
+    m_connectionName = connName;
+    m_db = QSqlDatabase::addDatabase("QSQLITE", connName);
+    m_db.setDatabaseName(filePath);
+    // 多个线程连接并发写入时等待锁释放，而不是立即返回database is locked
+    m_db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+    if (!m_db.open()) {
+        qWarning() << "SQLite数据库打开失败:" << m_db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QSqlDatabase DatabaseWorker::threadDatabase() {
+    // 创建连接的线程直接使用原连接
+    if (QThread::currentThread() == thread()) {
+        return m_db;
+    }
+
+    QString threadConnName = QString("%1_%2")
+                             .arg(m_connectionName)
+                             .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()), 0, 16);
+
     QMutexLocker locker(&m_mutex);
-    QSqlQuery query(m_db);
+    if (QSqlDatabase::contains(threadConnName)) {
+        return QSqlDatabase::database(threadConnName);
+    }
+
+    // 为当前线程克隆一份连接（相同的驱动和连接参数）
+    QSqlDatabase db = QSqlDatabase::cloneDatabase(m_db, threadConnName);
+    if (!db.open()) {
+        qWarning() << "线程数据库连接失败:" << db.lastError().text();
+    } else {
+        qDebug() << "已为线程创建数据库连接:" << threadConnName;
+    }
+    return db;
+}
+
+QJsonArray DatabaseWorker::queryData(const QString &sql) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery query(threadDatabase());
     QJsonArray result;
 
     qDebug() << "执行SQL语句:" << sql;
 
-    if (query.exec(sql)) {
+    // 调用线程上的请求上下文（由RequestHandler设置）
+    const RequestTracer::Context trace = RequestTracer::current();
+    bool executed;
+    {
+        RequestTracer::Span span(trace, "db.exec");
+        executed = query.exec(sql);
+    }
+
+    if (executed) {
         qDebug() << "查询执行成功.";
+        RequestTracer::Span span(trace, "db.fetch");
         const QSqlRecord record = query.record();
         int rowCount = 0;
 
@@ -49,21 +129,73 @@ QJsonArray DatabaseWorker::queryData(const QString &sql) {
             rowCount++;
             QJsonObject obj;
             for (int i = 0; i < record.count(); ++i) { 
-                QString fieldName = record.fieldName(i);
-                QVariant value = query.value(i);
-                qDebug() << "  字段:" << fieldName << "值:" << value.toString();
-                obj.insert(fieldName, QJsonValue::fromVariant(value));
+                obj.insert(record.fieldName(i), QJsonValue::fromVariant(query.value(i)));
             }
             result.append(obj);
         }
         qDebug() << "查询返回行数:" << rowCount;
     } else {
         qWarning() << "查询执行失败:" << query.lastError().text() << "SQL:" << sql;
+        queryMetrics().errors->inc();
     }
-    
-    // 打印结果的JSON表示形式
-    QJsonDocument doc(result);
-    qDebug() << "查询结果:" << doc.toJson(QJsonDocument::Compact);
-    
+    queryMetrics().total->inc();
+    queryMetrics().duration->observeNanoseconds(timer.nsecsElapsed());
+
+    // 不再逐字段、逐行打印结果：大结果集时日志本身就是主要开销
     return result;
 }
+
+bool DatabaseWorker::streamQuery(const QString &sql, int batchSize,
+                                 const std::function<bool(const QJsonArray &rows)> &consumer) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery query(threadDatabase());
+    // 只向前遍历：驱动不缓存已读过的行（QMYSQL此时逐行从服务器拉取结果）
+    query.setForwardOnly(true);
+
+    qDebug() << "执行流式SQL语句:" << sql;
+
+    bool ok;
+    {
+        RequestTracer::Span span("db.exec");
+        ok = query.exec(sql);
+    }
+    if (ok) {
+        const QSqlRecord record = query.record();
+        QStringList fieldNames;
+        for (int i = 0; i < record.count(); ++i) {
+            fieldNames.append(record.fieldName(i));
+        }
+
+        QJsonArray batch;
+        qint64 rowCount = 0;
+        bool stopped = false;
+        while (query.next()) {
+            QJsonObject obj;
+            for (int i = 0; i < fieldNames.size(); ++i) {
+                obj.insert(fieldNames[i], QJsonValue::fromVariant(query.value(i)));
+            }
+            batch.append(obj);
+            rowCount++;
+
+            if (batch.size() >= batchSize) {
+                if (!consumer(batch)) {
+                    stopped = true;
+                    break;
+                }
+                batch = QJsonArray();
+            }
+        }
+        if (!stopped && !batch.isEmpty()) {
+            stopped = !consumer(batch);
+        }
+        qDebug() << "流式查询结束，已发送行数:" << rowCount << (stopped ? "(消费方已停止)" : "");
+    } else {
+        qWarning() << "查询执行失败:" << query.lastError().text() << "SQL:" << sql;
+        queryMetrics().errors->inc();
+    }
+    queryMetrics().total->inc();
+    queryMetrics().duration->observeNanoseconds(timer.nsecsElapsed());
+    return ok;
+}
@@ -4,6 +4,8 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QMutex>
+#include <QJsonArray>
+#include <functional>
 
 class DatabaseWorker : public QObject {
     Q_OBJECT
@@ -12,10 +14,22 @@ public:
     bool connect(const QString &host, int port, 
                 const QString &user, const QString &password,
                 const QString &dbName);
+    // 使用本地SQLite文件代替MySQL（压测等无MySQL环境），各线程的克隆连接共享同一文件
+    bool connectSqlite(const QString &filePath);
+    // 可在任意线程调用：每个线程使用各自克隆的数据库连接
     QJsonArray queryData(const QString &sql);
+    // 流式查询：只向前遍历结果集，每读满batchSize行交给consumer一次，不在内存中保留整个结果。
+    // consumer返回false时停止读取（例如客户端已断开）；返回值表示查询是否执行成功
+    bool streamQuery(const QString &sql, int batchSize,
+                     const std::function<bool(const QJsonArray &rows)> &consumer);
 
 private:
     QSqlDatabase m_db;
+    QString m_connectionName;
+    // 只保护线程连接的创建，查询本身不再串行化
     QMutex m_mutex;
+
+    // 获取当前线程专用的数据库连接（QSqlDatabase不能跨线程使用）
+    QSqlDatabase threadDatabase();
 };
 #endif // DATABASEWORKER_H
\ No newline at end of file
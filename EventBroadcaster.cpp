@@ -0,0 +1,146 @@
+#include "EventBroadcaster.h"
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QDebug>
+
+EventSubscriber::EventSubscriber(int capacity)
+    : m_capacity(capacity)
+{
+}
+
+void EventSubscriber::push(const QByteArray& event)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_queue.size() >= m_capacity) {
+            // 丢弃最旧的事件，客户端始终能拿到最新状态
+            m_queue.dequeue();
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_queue.enqueue(event);
+    }
+
+    // 同一批事件只触发一次通知，消费方取走全部事件后才会再次通知。
+    // 回调在锁内执行，setNotifier(nullptr)返回后回调不会再被调用
+    if (!m_notifyPending.exchange(true, std::memory_order_acq_rel)) {
+        QMutexLocker locker(&m_mutex);
+        if (m_notifier) {
+            m_notifier();
+        }
+    }
+}
+
+QList<QByteArray> EventSubscriber::takeAll()
+{
+    m_notifyPending.store(false, std::memory_order_release);
+
+    QMutexLocker locker(&m_mutex);
+    QList<QByteArray> events;
+    events.reserve(m_queue.size());
+    while (!m_queue.isEmpty()) {
+        events.append(m_queue.dequeue());
+    }
+    return events;
+}
+
+void EventSubscriber::setNotifier(std::function<void()> notifier)
+{
+    QMutexLocker locker(&m_mutex);
+    m_notifier = std::move(notifier);
+}
+
+EventBroadcaster::EventBroadcaster(QObject* parent)
+    : QObject(parent)
+{
+}
+
+std::shared_ptr<EventSubscriber> EventBroadcaster::subscribe()
+{
+    auto subscriber = std::make_shared<EventSubscriber>(m_subscriberCapacity);
+
+    QMutexLocker locker(&m_mutex);
+    // 补发最新状态
+    for (const QByteArray& event : m_lastEvents) {
+        subscriber->push(event);
+    }
+    m_subscribers.push_back(subscriber);
+
+    qDebug() << "新的事件流订阅，当前订阅数:" << m_subscribers.size();
+    return subscriber;
+}
+
+int EventBroadcaster::subscriberCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const auto& subscriber : m_subscribers) {
+        if (!subscriber.expired()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void EventBroadcaster::publish(const QString& type, const QJsonObject& data)
+{
+    QJsonObject payload = data;
+    payload["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+
+    // 只格式化一次，所有订阅者共享同一份数据
+    QByteArray event;
+    event.reserve(128);
+    event.append("id: ").append(QByteArray::number(m_nextEventId++)).append('\n');
+    event.append("event: ").append(type.toUtf8()).append('\n');
+    event.append("data: ").append(QJsonDocument(payload).toJson(QJsonDocument::Compact)).append("\n\n");
+
+    m_lastEvents[type] = event;
+
+    // 推送并顺便清理已断开的订阅者
+    auto it = m_subscribers.begin();
+    while (it != m_subscribers.end()) {
+        if (std::shared_ptr<EventSubscriber> subscriber = it->lock()) {
+            subscriber->push(event);
+            ++it;
+        } else {
+            it = m_subscribers.erase(it);
+        }
+    }
+}
+
+void EventBroadcaster::publishNavigation(const QString& direction, const QString& distance)
+{
+    QJsonObject data;
+    data["direction"] = direction;
+    data["distance"] = distance;
+    publish("navigation", data);
+}
+
+void EventBroadcaster::publishPageSwitch(int pageIndex)
+{
+    QJsonObject data;
+    data["pageIndex"] = pageIndex;
+    publish("page", data);
+}
+
+void EventBroadcaster::publishBackToMain()
+{
+    QJsonObject data;
+    data["pageIndex"] = 0;
+    publish("page", data);
+}
+
+void EventBroadcaster::publishPdfNextPage()
+{
+    QJsonObject data;
+    data["action"] = "next";
+    publish("pdf", data);
+}
+
+void EventBroadcaster::publishPdfPrevPage()
+{
+    QJsonObject data;
+    data["action"] = "prev";
+    publish("pdf", data);
+}
@@ -0,0 +1,79 @@
+#ifndef EVENTBROADCASTER_H
+#define EVENTBROADCASTER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMutex>
+#include <QQueue>
+#include <QMap>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// 单个事件流订阅者的有界缓冲区
+// 发布方可在任意线程写入；缓冲区满时丢弃最旧的事件，保证慢客户端不会占用无限内存
+class EventSubscriber
+{
+public:
+    explicit EventSubscriber(int capacity);
+
+    // 写入一条已格式化的事件
+    void push(const QByteArray& event);
+
+    // 取出全部待发送事件
+    QList<QByteArray> takeAll();
+
+    // 因缓冲区满而丢弃的事件数
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // 设置有新事件时的通知回调（在发布线程调用，同一批事件只通知一次）；
+    // 回调应只做投递（如排队调用），不能再访问本订阅者
+    void setNotifier(std::function<void()> notifier);
+
+private:
+    QMutex m_mutex;
+    QQueue<QByteArray> m_queue;
+    int m_capacity;
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<bool> m_notifyPending{false};
+    std::function<void()> m_notifier;
+};
+
+// 事件广播：把导航、页面、PDF状态变化扇出给所有 /api/events 订阅者
+class EventBroadcaster : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EventBroadcaster(QObject* parent = nullptr);
+
+    // 每个订阅者缓冲的最大事件数
+    void setSubscriberCapacity(int capacity) { m_subscriberCapacity = qMax(1, capacity); }
+
+    // 新建订阅，订阅者会先收到各类事件的最新状态
+    std::shared_ptr<EventSubscriber> subscribe();
+
+    int subscriberCount() const;
+
+public slots:
+    // 以下槽可在任意线程直接调用
+    void publishNavigation(const QString& direction, const QString& distance);
+    void publishPageSwitch(int pageIndex);
+    void publishBackToMain();
+    void publishPdfNextPage();
+    void publishPdfPrevPage();
+
+private:
+    mutable QMutex m_mutex;
+    std::vector<std::weak_ptr<EventSubscriber>> m_subscribers;
+    // 每类事件最近一次的格式化结果，供新订阅者补发
+    QMap<QString, QByteArray> m_lastEvents;
+    quint64 m_nextEventId = 1;
+    int m_subscriberCapacity = 64;
+
+    // 格式化为SSE文本并推送给所有订阅者
+    void publish(const QString& type, const QJsonObject& data);
+};
+
+#endif // EVENTBROADCASTER_H
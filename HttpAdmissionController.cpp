@@ -0,0 +1,252 @@
+#include "HttpAdmissionController.h"
+#include <QTcpSocket>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+// 客户端记录空闲多久后可被清理
+const qint64 kClientIdleExpiryMs = 60000;
+const qint64 kPruneIntervalMs = 10000;
+
+int classIndex(HttpAdmissionController::RouteClass routeClass)
+{
+    return static_cast<int>(routeClass);
+}
+}
+
+HttpAdmissionController::Ticket::Ticket(HttpAdmissionController* controller, RouteClass routeClass)
+    : m_controller(controller), m_routeClass(routeClass)
+{
+}
+
+HttpAdmissionController::Ticket::Ticket(Ticket&& other) noexcept
+    : m_controller(other.m_controller), m_routeClass(other.m_routeClass)
+{
+    other.m_controller = nullptr;
+}
+
+HttpAdmissionController::Ticket& HttpAdmissionController::Ticket::operator=(Ticket&& other) noexcept
+{
+    if (this != &other) {
+        if (m_controller) {
+            m_controller->releaseInFlight(m_routeClass);
+        }
+        m_controller = other.m_controller;
+        m_routeClass = other.m_routeClass;
+        other.m_controller = nullptr;
+    }
+    return *this;
+}
+
+HttpAdmissionController::Ticket::~Ticket()
+{
+    if (m_controller) {
+        m_controller->releaseInFlight(m_routeClass);
+    }
+}
+
+HttpAdmissionController::HttpAdmissionController()
+{
+    // 控制类接口配额宽松，保证负载高时翻页、切页仍能及时响应
+    m_limits[classIndex(RouteClass::Control)] = {50.0, 100, 32, 32};
+    // 批量类请求在批量线程池中执行，同时处理的数量与其线程数相当即可，其余在队列中等待
+    m_limits[classIndex(RouteClass::Bulk)] = {10.0, 20, 4, 16};
+    m_limits[classIndex(RouteClass::Default)] = {20.0, 40, 16, 16};
+
+    m_clock.start();
+}
+
+void HttpAdmissionController::setClassLimits(RouteClass routeClass, const ClassLimits& limits)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits[classIndex(routeClass)] = limits;
+}
+
+HttpAdmissionController::ClassLimits HttpAdmissionController::classLimits(RouteClass routeClass) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limits[classIndex(routeClass)];
+}
+
+const char* HttpAdmissionController::routeClassName(RouteClass routeClass)
+{
+    switch (routeClass) {
+    case RouteClass::Control:
+        return "control";
+    case RouteClass::Bulk:
+        return "bulk";
+    default:
+        return "default";
+    }
+}
+
+bool HttpAdmissionController::tryAdmitConnection()
+{
+    int current = m_connections.load(std::memory_order_relaxed);
+    while (current < m_maxConnections) {
+        if (m_connections.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpAdmissionController::tryAdmitClient(const QString& clientAddress)
+{
+    QMutexLocker locker(&m_mutex);
+    ClientState& client = m_clients[clientAddress];
+    client.lastSeenMs = m_clock.elapsed();
+    if (client.connections >= m_maxConnectionsPerClient) {
+        return false;
+    }
+    client.connections++;
+    return true;
+}
+
+void HttpAdmissionController::releaseConnection(const QString& clientAddress)
+{
+    m_connections.fetch_sub(1, std::memory_order_relaxed);
+
+    if (clientAddress.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto it = m_clients.find(clientAddress);
+    if (it != m_clients.end() && it->connections > 0) {
+        it->connections--;
+        it->lastSeenMs = m_clock.elapsed();
+    }
+}
+
+HttpAdmissionController::Decision HttpAdmissionController::checkRequest(
+    const QString& clientAddress, RouteClass routeClass)
+{
+    QMutexLocker locker(&m_mutex);
+    const ClassLimits& limits = m_limits[classIndex(routeClass)];
+
+    qint64 nowMs = m_clock.elapsed();
+    if (nowMs - m_lastPruneMs > kPruneIntervalMs) {
+        pruneClients(nowMs);
+    }
+
+    ClientState& client = m_clients[clientAddress];
+    client.lastSeenMs = nowMs;
+    if (!takeToken(client, routeClass, nowMs)) {
+        return Decision::RateLimited;
+    }
+
+    // 名额和队列都已满时不必等请求体传完再拒绝
+    if (limits.maxInFlight > 0 && m_inFlight[classIndex(routeClass)] >= limits.maxInFlight
+        && m_waiters[classIndex(routeClass)].size() >= limits.maxQueued) {
+        return Decision::Overloaded;
+    }
+    return Decision::Admit;
+}
+
+HttpAdmissionController::Decision HttpAdmissionController::acquireSlot(
+    RouteClass routeClass, Ticket& ticket, Waiter waiter, quint64& waitId)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const ClassLimits& limits = m_limits[classIndex(routeClass)];
+        int& inFlight = m_inFlight[classIndex(routeClass)];
+        if (limits.maxInFlight > 0 && inFlight >= limits.maxInFlight) {
+            QQueue<QueuedWaiter>& waiters = m_waiters[classIndex(routeClass)];
+            if (waiters.size() >= limits.maxQueued) {
+                return Decision::Overloaded;
+            }
+            waitId = m_nextWaitId++;
+            waiters.enqueue({waitId, std::move(waiter)});
+            return Decision::Queued;
+        }
+        inFlight++;
+    }
+
+    // 在锁外赋值：ticket原先持有的名额归还时需要再次加锁
+    ticket = Ticket(this, routeClass);
+    return Decision::Admit;
+}
+
+void HttpAdmissionController::cancelWait(RouteClass routeClass, quint64 waitId)
+{
+    QMutexLocker locker(&m_mutex);
+    QQueue<QueuedWaiter>& waiters = m_waiters[classIndex(routeClass)];
+    for (auto it = waiters.begin(); it != waiters.end(); ++it) {
+        if (it->id == waitId) {
+            waiters.erase(it);
+            return;
+        }
+    }
+}
+
+bool HttpAdmissionController::takeToken(ClientState& client, RouteClass routeClass, qint64 nowMs)
+{
+    const ClassLimits& limits = m_limits[classIndex(routeClass)];
+    if (limits.ratePerSecond <= 0) {
+        return true;
+    }
+
+    TokenBucket& bucket = client.buckets[classIndex(routeClass)];
+    if (bucket.tokens < 0) {
+        bucket.tokens = limits.burst;
+    } else {
+        double refill = (nowMs - bucket.lastRefillMs) * limits.ratePerSecond / 1000.0;
+        bucket.tokens = qMin(static_cast<double>(limits.burst), bucket.tokens + refill);
+    }
+    bucket.lastRefillMs = nowMs;
+
+    if (bucket.tokens < 1.0) {
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void HttpAdmissionController::releaseInFlight(RouteClass routeClass)
+{
+    QMutexLocker locker(&m_mutex);
+    QQueue<QueuedWaiter>& waiters = m_waiters[classIndex(routeClass)];
+    if (waiters.isEmpty()) {
+        m_inFlight[classIndex(routeClass)]--;
+        return;
+    }
+    // 名额直接交给队首的请求，处理中计数不变。回调在锁内执行，
+    // 与cancelWait互斥：连接撤销等待之后不会再收到回调
+    QueuedWaiter next = waiters.dequeue();
+    next.waiter(Ticket(this, routeClass));
+}
+
+void HttpAdmissionController::pruneClients(qint64 nowMs)
+{
+    m_lastPruneMs = nowMs;
+    for (auto it = m_clients.begin(); it != m_clients.end();) {
+        if (it->connections == 0 && nowMs - it->lastSeenMs > kClientIdleExpiryMs) {
+            it = m_clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void HttpAdmissionController::rejectSocket(QTcpSocket* socket, bool plainHttp)
+{
+    if (plainHttp && socket->state() == QTcpSocket::ConnectedState) {
+        static const QByteArray kServiceUnavailable =
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Retry-After: 1\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n";
+        socket->write(kServiceUnavailable);
+        socket->disconnectFromHost();
+    } else {
+        socket->abort();
+    }
+
+    if (socket->state() == QTcpSocket::UnconnectedState) {
+        socket->deleteLater();
+    } else {
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        // 对端不读取数据时不无限等待
+        QTimer::singleShot(5000, socket, [socket]() { socket->abort(); });
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef HTTPADMISSIONCONTROLLER_H
+#define HTTPADMISSIONCONTROLLER_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <atomic>
+#include <functional>
+
+class QTcpSocket;
+
+// 准入控制：全局/单客户端连接数上限、按路由类别的单IP令牌桶限速，
+// 以及每个类别同时处理中的请求数上限。名额用完时请求进入该类别有界的FIFO等待队列
+// （异步等待，不阻塞工作线程），队列也满时才拒绝。
+// 所有方法线程安全，由HttpServer和各工作线程共享
+class HttpAdmissionController
+{
+public:
+    // 路由类别，记在RequestHandler路由表的每个路由上，是请求唯一的类别属性：
+    // 既决定准入配额，也决定处理函数和延迟响应在哪个线程池执行。
+    // 控制类接口使用独立的配额，数据库查询和上传再多也不会挤占
+    enum class RouteClass {
+        Control,  // 页面切换、PDF翻页、导航等轻量控制接口
+        Bulk,     // 数据库读写、导出和上传，在批量线程池执行
+        Default,
+        Count
+    };
+
+    struct ClassLimits {
+        // 单IP令牌补充速率（每秒请求数），<=0表示不限速
+        double ratePerSecond;
+        // 单IP允许的突发请求数
+        int burst;
+        // 全部客户端同时处理中的请求上限，<=0表示不限制
+        int maxInFlight;
+        // 名额用完时最多排队等待的请求数，0表示不排队直接拒绝
+        int maxQueued;
+    };
+
+    enum class Decision {
+        Admit,
+        Queued,       // 已进入等待队列，名额空出时通过回调交给请求
+        RateLimited,  // 429
+        Overloaded    // 503
+    };
+
+    // 已准入请求的凭据，析构时归还处理中名额
+    class Ticket
+    {
+    public:
+        Ticket() = default;
+        Ticket(HttpAdmissionController* controller, RouteClass routeClass);
+        Ticket(Ticket&& other) noexcept;
+        Ticket& operator=(Ticket&& other) noexcept;
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        ~Ticket();
+
+    private:
+        HttpAdmissionController* m_controller = nullptr;
+        RouteClass m_routeClass = RouteClass::Default;
+    };
+
+    // 排队的请求取得名额时调用：在释放名额的线程、持有内部锁时执行，
+    // 只能取走ticket并投递到请求所在线程，不能调用本对象的其他方法
+    using Waiter = std::function<void(Ticket ticket)>;
+
+    HttpAdmissionController();
+
+    // 以下设置应在服务器开始接受连接之前完成
+    void setMaxConnections(int count) { m_maxConnections = qMax(1, count); }
+    void setMaxConnectionsPerClient(int count) { m_maxConnectionsPerClient = qMax(1, count); }
+    void setClassLimits(RouteClass routeClass, const ClassLimits& limits);
+    ClassLimits classLimits(RouteClass routeClass) const;
+    // 用于指标标签和日志
+    static const char* routeClassName(RouteClass routeClass);
+
+    // 连接准入：接受连接时调用（尚不知道对端地址），失败时不占用名额
+    bool tryAdmitConnection();
+    // 已知对端地址后调用，失败时由调用方继续调用releaseConnection(QString())
+    bool tryAdmitClient(const QString& clientAddress);
+    // 连接关闭；clientAddress为空表示该连接未通过tryAdmitClient
+    void releaseConnection(const QString& clientAddress);
+
+    int activeConnections() const { return m_connections.load(std::memory_order_relaxed); }
+
+    // 请求头到达、读取请求体之前调用：按单IP令牌桶限速，名额和等待队列都已满时提前拒绝。
+    // routeClass为匹配路由的类别（由RequestHandler的路由表给出）
+    Decision checkRequest(const QString& clientAddress, RouteClass routeClass);
+
+    // 请求体接收完毕后取得处理中名额：有空闲名额时返回Admit并由ticket持有；
+    // 否则进入FIFO等待队列返回Queued，waitId用于cancelWait；队列已满时返回Overloaded。
+    // 慢速上传在接收请求体期间不占用名额
+    Decision acquireSlot(RouteClass routeClass, Ticket& ticket, Waiter waiter, quint64& waitId);
+    // 撤销仍在队列中的等待（连接关闭）；已取得名额的等待不受影响
+    void cancelWait(RouteClass routeClass, quint64 waitId);
+
+    // 在未交给连接对象的套接字上直接回复503并关闭；TLS握手前只能直接断开
+    static void rejectSocket(QTcpSocket* socket, bool plainHttp);
+
+private:
+    struct TokenBucket {
+        double tokens = -1;  // <0表示尚未初始化
+        qint64 lastRefillMs = 0;
+    };
+
+    struct ClientState {
+        int connections = 0;
+        qint64 lastSeenMs = 0;
+        TokenBucket buckets[static_cast<int>(RouteClass::Count)];
+    };
+
+    int m_maxConnections = 256;
+    int m_maxConnectionsPerClient = 32;
+    ClassLimits m_limits[static_cast<int>(RouteClass::Count)];
+
+    struct QueuedWaiter {
+        quint64 id;
+        Waiter waiter;
+    };
+
+    std::atomic<int> m_connections{0};
+    // 处理中的请求数和等待队列，受m_mutex保护
+    int m_inFlight[static_cast<int>(RouteClass::Count)] = {};
+    QQueue<QueuedWaiter> m_waiters[static_cast<int>(RouteClass::Count)];
+    quint64 m_nextWaitId = 1;
+
+    mutable QMutex m_mutex;
+    QHash<QString, ClientState> m_clients;
+    QElapsedTimer m_clock;
+    qint64 m_lastPruneMs = 0;
+
+    bool takeToken(ClientState& client, RouteClass routeClass, qint64 nowMs);
+    void releaseInFlight(RouteClass routeClass);
+    // 清理长时间无活动且没有连接的客户端记录
+    void pruneClients(qint64 nowMs);
+};
+
+#endif // HTTPADMISSIONCONTROLLER_H
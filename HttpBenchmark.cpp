@@ -0,0 +1,609 @@
+// HttpServer压测程序
+// 在本进程内启动HttpServer（SQLite代替MySQL），由若干负载线程上的闭环客户端
+// 按配置的路由比例持续发送请求：每个客户端收到响应后才发送下一个请求。
+// 结束后输出各路由及总体的p50/p90/p99/p999延迟和每秒请求数。
+//
+// 用法示例:
+//   http_benchmark --clients 32 --duration 20 --mix "GET /api/data*4,GET /api/navigation/data*4"
+//   http_benchmark --no-keep-alive --server-threads 4
+//   http_benchmark --no-keep-alive --tls-cert server.crt --tls-key server.key --tls-resume
+//     （短连接+TLS时每个请求都要握手，单独输出握手延迟；--tls-resume让客户端复用会话票据）
+
+#include "Httpserver.h"
+#include "Databaseworker.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QDebug>
+#if HAS_SSL
+#include <QSslSocket>
+#include <QSslConfiguration>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchmarkRoute {
+    QString label;
+    int weight = 1;
+    // 预先渲染好的完整请求（分别用于持久连接和短连接）
+    QByteArray keepAliveRequest;
+    QByteArray closeRequest;
+};
+
+struct BenchmarkConfig {
+    QHostAddress host = QHostAddress::LocalHost;
+    quint16 port = 0;
+    bool keepAlive = true;
+    std::vector<BenchmarkRoute> routes;
+    int totalWeight = 0;
+    BenchClock::time_point measureStart;
+    BenchClock::time_point stopAt;
+#if HAS_SSL
+    bool tls = false;
+    // 客户端复用上次握手得到的会话票据
+    bool tlsResume = false;
+    QSslConfiguration tlsConfiguration;
+#endif
+};
+
+// 单个路由的测量结果
+struct RouteStats {
+    std::vector<qint64> latenciesNs;
+    quint64 errors = 0;
+};
+
+// 已知路由的默认请求体
+QByteArray defaultBody(const QString& path)
+{
+    if (path == "/api/navigation") {
+        return R"({"action":"update_navigation","direction":"left","distance":"100m"})";
+    }
+    if (path == "/api/data") {
+        return R"({"recognized_text":"benchmark","translated_text":"benchmark"})";
+    }
+    if (path == "/api/execute-sql") {
+        return R"({"sql":"SELECT COUNT(*) AS total FROM translations"})";
+    }
+    return QByteArray();
+}
+
+QByteArray renderRequest(const QString& method, const QString& target, const QByteArray& body,
+                         bool keepAlive, bool acceptGzip)
+{
+    QByteArray request;
+    request.append(method.toLatin1()).append(' ').append(target.toUtf8()).append(" HTTP/1.1\r\n");
+    request.append("Host: 127.0.0.1\r\n");
+    request.append("User-Agent: ar-http-benchmark\r\n");
+    if (acceptGzip) {
+        request.append("Accept-Encoding: gzip, deflate\r\n");
+    }
+    request.append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    if (!body.isEmpty() || method == "POST") {
+        request.append("Content-Type: application/json\r\n");
+        request.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    }
+    request.append("\r\n");
+    request.append(body);
+    return request;
+}
+
+// 解析--mix参数：逗号分隔的"METHOD PATH*权重"，权重缺省为1
+bool parseMix(const QString& mix, bool acceptGzip, BenchmarkConfig& config)
+{
+    const QStringList entries = mix.split(',', Qt::SkipEmptyParts);
+    for (const QString& rawEntry : entries) {
+        QString entry = rawEntry.trimmed();
+        int weight = 1;
+        int star = entry.lastIndexOf('*');
+        if (star > 0) {
+            bool ok = false;
+            weight = entry.mid(star + 1).toInt(&ok);
+            if (!ok || weight <= 0) {
+                return false;
+            }
+            entry = entry.left(star).trimmed();
+        }
+
+        const QStringList parts = entry.split(' ', Qt::SkipEmptyParts);
+        if (parts.size() != 2) {
+            return false;
+        }
+        QString method = parts.at(0).toUpper();
+        QString target = parts.at(1);
+        QByteArray body = method == "POST" ? defaultBody(target.section('?', 0, 0)) : QByteArray();
+
+        BenchmarkRoute route;
+        route.label = method + " " + target;
+        route.weight = weight;
+        route.keepAliveRequest = renderRequest(method, target, body, true, acceptGzip);
+        route.closeRequest = renderRequest(method, target, body, false, acceptGzip);
+        config.routes.push_back(route);
+        config.totalWeight += weight;
+    }
+    return !config.routes.empty();
+}
+
+qint64 percentile(const std::vector<qint64>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[qBound<size_t>(1, rank, sorted.size()) - 1];
+}
+
+// 基准测试期间丢弃服务器的调试输出，避免日志本身成为瓶颈
+void quietMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+}
+
+}
+
+// 闭环客户端：同一时间只有一个未完成的请求
+class BenchmarkClient : public QObject
+{
+    Q_OBJECT
+public:
+    BenchmarkClient(const BenchmarkConfig& config, quint32 seed, QObject* parent = nullptr)
+        : QObject(parent),
+          m_config(config),
+          m_random(seed),
+          m_stats(config.routes.size())
+    {
+#if HAS_SSL
+        if (m_config.tls) {
+            QSslSocket* sslSocket = new QSslSocket(this);
+            connect(sslSocket, &QSslSocket::encrypted, this, &BenchmarkClient::onEncrypted);
+            m_socket = sslSocket;
+        } else {
+            m_socket = new QTcpSocket(this);
+        }
+#else
+        m_socket = new QTcpSocket(this);
+#endif
+        connect(m_socket, &QTcpSocket::connected, this, &BenchmarkClient::onConnected);
+        connect(m_socket, &QTcpSocket::readyRead, this, &BenchmarkClient::onReadyRead);
+        connect(m_socket, &QTcpSocket::errorOccurred, this, &BenchmarkClient::onSocketError);
+    }
+
+    const std::vector<RouteStats>& stats() const { return m_stats; }
+    const RouteStats& handshakeStats() const { return m_handshakeStats; }
+
+public slots:
+    void start() { sendNext(); }
+
+signals:
+    void finished();
+
+private slots:
+    void onConnected()
+    {
+        m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+#if HAS_SSL
+        // TLS连接等握手完成后再发送请求
+        if (m_config.tls) {
+            return;
+        }
+#endif
+        if (m_currentRoute >= 0) {
+            writeCurrentRequest();
+        }
+    }
+
+#if HAS_SSL
+    void onEncrypted()
+    {
+        BenchClock::time_point now = BenchClock::now();
+        if (now >= m_config.measureStart && now <= m_config.stopAt) {
+            m_handshakeStats.latenciesNs.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_requestStart).count());
+        }
+
+        QSslSocket* sslSocket = static_cast<QSslSocket*>(m_socket);
+        if (m_config.tlsResume) {
+            m_sessionTicket = sslSocket->sslConfiguration().sessionTicket();
+        }
+        if (m_currentRoute >= 0) {
+            writeCurrentRequest();
+        }
+    }
+#endif
+
+    void onReadyRead()
+    {
+        m_buffer.append(m_socket->readAll());
+        if (m_currentRoute < 0) {
+            m_buffer.clear();
+            return;
+        }
+
+        int headerEnd = m_buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        // 只解析状态码、Content-Length和Connection，足以界定响应边界
+        QByteArray head = m_buffer.left(headerEnd + 2).toLower();
+        int status = m_buffer.mid(9, 3).toInt();
+        qint64 contentLength = 0;
+        int lengthPos = head.indexOf("\r\ncontent-length:");
+        if (lengthPos >= 0) {
+            int valueStart = lengthPos + 17;
+            int valueEnd = head.indexOf("\r\n", valueStart);
+            contentLength = head.mid(valueStart, valueEnd - valueStart).trimmed().toLongLong();
+        }
+        qint64 total = headerEnd + 4 + contentLength;
+        if (m_buffer.size() < total) {
+            return;
+        }
+        bool serverCloses = head.contains("\r\nconnection: close");
+
+        m_buffer.remove(0, total);
+        completeRequest(status < 400);
+
+        if (!m_config.keepAlive || serverCloses) {
+            m_socket->abort();
+            m_buffer.clear();
+        }
+        sendNext();
+    }
+
+    void onSocketError(QAbstractSocket::SocketError)
+    {
+        if (m_currentRoute < 0) {
+            return;
+        }
+        // 请求进行中连接中断：记为错误，稍后重连
+#if HAS_SSL
+        if (m_config.tls && !static_cast<QSslSocket*>(m_socket)->isEncrypted()) {
+            m_handshakeStats.errors++;
+        }
+#endif
+        completeRequest(false);
+        m_socket->abort();
+        m_buffer.clear();
+        QTimer::singleShot(10, this, &BenchmarkClient::sendNext);
+    }
+
+private:
+    const BenchmarkConfig& m_config;
+    QRandomGenerator m_random;
+    std::vector<RouteStats> m_stats;
+    QTcpSocket* m_socket;
+    QByteArray m_buffer;
+    int m_currentRoute = -1;
+    BenchClock::time_point m_requestStart;
+    bool m_finished = false;
+    RouteStats m_handshakeStats;
+#if HAS_SSL
+    QByteArray m_sessionTicket;
+#endif
+
+    void sendNext()
+    {
+        if (m_finished) {
+            return;
+        }
+        if (BenchClock::now() >= m_config.stopAt) {
+            m_finished = true;
+            m_socket->abort();
+            emit finished();
+            return;
+        }
+
+        // 按权重随机选择路由
+        int pick = static_cast<int>(m_random.bounded(static_cast<quint32>(m_config.totalWeight)));
+        m_currentRoute = 0;
+        while (pick >= m_config.routes[m_currentRoute].weight) {
+            pick -= m_config.routes[m_currentRoute].weight;
+            m_currentRoute++;
+        }
+
+        // 短连接模式下延迟包含建立连接的时间
+        m_requestStart = BenchClock::now();
+        if (m_socket->state() == QAbstractSocket::ConnectedState) {
+            writeCurrentRequest();
+        } else {
+            // 首次请求、短连接模式或服务器已关闭空闲连接
+            m_socket->abort();
+            m_buffer.clear();
+#if HAS_SSL
+            if (m_config.tls) {
+                QSslSocket* sslSocket = static_cast<QSslSocket*>(m_socket);
+                QSslConfiguration configuration = m_config.tlsConfiguration;
+                if (!m_sessionTicket.isEmpty()) {
+                    configuration.setSessionTicket(m_sessionTicket);
+                }
+                sslSocket->setSslConfiguration(configuration);
+                sslSocket->connectToHostEncrypted(m_config.host.toString(), m_config.port);
+                return;
+            }
+#endif
+            m_socket->connectToHost(m_config.host, m_config.port);
+        }
+    }
+
+    void writeCurrentRequest()
+    {
+        const BenchmarkRoute& route = m_config.routes[m_currentRoute];
+        m_socket->write(m_config.keepAlive ? route.keepAliveRequest : route.closeRequest);
+    }
+
+    void completeRequest(bool success)
+    {
+        BenchClock::time_point now = BenchClock::now();
+        RouteStats& stats = m_stats[m_currentRoute];
+        m_currentRoute = -1;
+
+        // 只统计预热结束后、测量窗口内完成的请求
+        if (now < m_config.measureStart || now > m_config.stopAt) {
+            return;
+        }
+        if (success) {
+            stats.latenciesNs.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_requestStart).count());
+        } else {
+            stats.errors++;
+        }
+    }
+};
+
+// 负载线程：在本线程的事件循环中运行一组客户端
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    LoadGenerator(const BenchmarkConfig& config, int clientCount, quint32 seed)
+        : m_config(config), m_clientCount(clientCount), m_seed(seed)
+    {
+    }
+
+    // 所有客户端结束后由主线程读取（线程已停止，无需加锁）
+    const std::vector<BenchmarkClient*>& clients() const { return m_clients; }
+
+public slots:
+    void start()
+    {
+        for (int i = 0; i < m_clientCount; ++i) {
+            BenchmarkClient* client = new BenchmarkClient(m_config, m_seed + i, this);
+            connect(client, &BenchmarkClient::finished, this, [this]() {
+                if (++m_finishedCount == m_clientCount) {
+                    emit finished();
+                }
+            });
+            m_clients.push_back(client);
+            client->start();
+        }
+    }
+
+signals:
+    void finished();
+
+private:
+    const BenchmarkConfig& m_config;
+    int m_clientCount;
+    quint32 m_seed;
+    int m_finishedCount = 0;
+    std::vector<BenchmarkClient*> m_clients;
+};
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("http_benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("HttpServer闭环压测");
+    parser.addHelpOption();
+    QCommandLineOption clientsOption("clients", "并发客户端数", "n", "16");
+    QCommandLineOption durationOption("duration", "测量时长（秒）", "seconds", "10");
+    QCommandLineOption warmupOption("warmup", "预热时长（秒），期间的请求不计入结果", "seconds", "2");
+    QCommandLineOption noKeepAliveOption("no-keep-alive", "每个请求使用新连接");
+    QCommandLineOption gzipOption("gzip", "请求头带Accept-Encoding: gzip, deflate");
+    QCommandLineOption serverThreadsOption("server-threads", "服务器连接处理线程数", "n", "2");
+    QCommandLineOption loadThreadsOption("load-threads", "负载生成线程数", "n", "2");
+    QCommandLineOption rowsOption("rows", "translations表预置行数", "n", "1000");
+    QCommandLineOption mixOption("mix", "路由比例，如\"GET /api/data*4,GET /api/navigation/data*1\"", "mix",
+        "GET /api/data*4,GET /api/navigation/data*4,GET /api/page/switch?index=0*1,"
+        "GET /api/pdf/control?action=next*1,POST /api/navigation*1");
+    QCommandLineOption verboseOption("verbose", "保留服务器调试输出");
+    QCommandLineOption tlsCertOption("tls-cert", "启用HTTPS，服务器证书（PEM）", "file");
+    QCommandLineOption tlsKeyOption("tls-key", "服务器私钥（PEM，ECDSA或RSA）", "file");
+    QCommandLineOption tlsResumeOption("tls-resume", "客户端重连时复用TLS会话票据");
+    parser.addOptions({clientsOption, durationOption, warmupOption, noKeepAliveOption, gzipOption,
+                       serverThreadsOption, loadThreadsOption, rowsOption, mixOption, verboseOption,
+                       tlsCertOption, tlsKeyOption, tlsResumeOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+
+    int clientCount = qMax(1, parser.value(clientsOption).toInt());
+    int durationSecs = qMax(1, parser.value(durationOption).toInt());
+    int warmupSecs = qMax(0, parser.value(warmupOption).toInt());
+    int loadThreadCount = qBound(1, parser.value(loadThreadsOption).toInt(), clientCount);
+    int seedRows = qMax(0, parser.value(rowsOption).toInt());
+
+    BenchmarkConfig config;
+    config.keepAlive = !parser.isSet(noKeepAliveOption);
+    if (!parseMix(parser.value(mixOption), parser.isSet(gzipOption), config)) {
+        fprintf(stderr, "无效的--mix参数\n");
+        return 1;
+    }
+
+    // 用临时SQLite文件代替MySQL
+    QTemporaryDir tempDir;
+    DatabaseWorker dbWorker;
+    if (!tempDir.isValid() || !dbWorker.connectSqlite(tempDir.filePath("benchmark.db"))) {
+        fprintf(stderr, "无法创建SQLite数据库\n");
+        return 1;
+    }
+    dbWorker.queryData("CREATE TABLE translations ("
+                       "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                       "recognized_text TEXT NOT NULL, "
+                       "translated_text TEXT NOT NULL, "
+                       "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP)");
+    dbWorker.queryData("BEGIN");
+    for (int i = 0; i < seedRows; ++i) {
+        dbWorker.queryData(QString("INSERT INTO translations (recognized_text, translated_text) "
+                                   "VALUES ('recognized text %1', 'translated text %1')").arg(i));
+    }
+    dbWorker.queryData("COMMIT");
+
+    // 压测时不启用准入限制，测量的是服务器本身的处理能力
+    HttpServer server(&dbWorker);
+    server.setWorkerThreadCount(parser.value(serverThreadsOption).toInt());
+    if (parser.isSet(tlsCertOption)) {
+#if HAS_SSL
+        if (!server.setupSslConfiguration(parser.value(tlsCertOption), parser.value(tlsKeyOption))) {
+            fprintf(stderr, "TLS证书或私钥加载失败\n");
+            return 1;
+        }
+        config.tls = true;
+        config.tlsResume = parser.isSet(tlsResumeOption);
+        config.tlsConfiguration = QSslConfiguration::defaultConfiguration();
+        // 自签名证书，压测客户端不校验
+        config.tlsConfiguration.setPeerVerifyMode(QSslSocket::VerifyNone);
+        config.tlsConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, !config.tlsResume);
+        config.tlsConfiguration.setSslOption(QSsl::SslOptionDisableSessionTickets, !config.tlsResume);
+#else
+        fprintf(stderr, "编译时没有启用SSL支持\n");
+        return 1;
+#endif
+    }
+    server.setMaxConnections(INT_MAX);
+    server.setMaxConnectionsPerClient(INT_MAX);
+    for (auto routeClass : {HttpAdmissionController::RouteClass::Control,
+                            HttpAdmissionController::RouteClass::Bulk,
+                            HttpAdmissionController::RouteClass::Default}) {
+        server.admissionController().setClassLimits(routeClass, {0.0, 0, 0, 0});
+    }
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        fprintf(stderr, "服务器监听失败: %s\n", qPrintable(server.errorString()));
+        return 1;
+    }
+    config.port = server.serverPort();
+
+    BenchClock::time_point startTime = BenchClock::now();
+    config.measureStart = startTime + std::chrono::seconds(warmupSecs);
+    config.stopAt = config.measureStart + std::chrono::seconds(durationSecs);
+
+    QTextStream out(stdout);
+    out << "端口 " << config.port << "，客户端 " << clientCount
+        << "，服务器线程 " << server.workerThreadCount()
+        << "，" << (config.keepAlive ? "持久连接" : "短连接")
+#if HAS_SSL
+        << (config.tls ? (config.tlsResume ? "，TLS（会话复用）" : "，TLS") : "")
+#endif
+        << "，预热 " << warmupSecs << "s，测量 " << durationSecs << "s\n";
+    out.flush();
+
+    // 客户端平均分配到各负载线程
+    std::vector<QThread*> threads;
+    std::vector<LoadGenerator*> generators;
+    int finishedGenerators = 0;
+    for (int i = 0; i < loadThreadCount; ++i) {
+        int count = clientCount / loadThreadCount + (i < clientCount % loadThreadCount ? 1 : 0);
+        QThread* thread = new QThread(&app);
+        LoadGenerator* generator = new LoadGenerator(config, count, 1000u * (i + 1));
+        generator->moveToThread(thread);
+        QObject::connect(generator, &LoadGenerator::finished, thread, &QThread::quit);
+        QObject::connect(thread, &QThread::finished, &app, [&]() {
+            if (++finishedGenerators == loadThreadCount) {
+                app.quit();
+            }
+        });
+        thread->start();
+        QMetaObject::invokeMethod(generator, &LoadGenerator::start, Qt::QueuedConnection);
+        threads.push_back(thread);
+        generators.push_back(generator);
+    }
+
+    // 卡住的请求不应让程序永远等待
+    QTimer::singleShot((warmupSecs + durationSecs + 10) * 1000, &app, [&]() {
+        fprintf(stderr, "部分客户端未能按时结束，强制停止\n");
+        for (QThread* thread : threads) {
+            thread->quit();
+        }
+    });
+
+    app.exec();
+    for (QThread* thread : threads) {
+        thread->wait();
+    }
+
+    // 汇总所有客户端的结果
+    std::vector<RouteStats> routeTotals(config.routes.size());
+    for (LoadGenerator* generator : generators) {
+        for (BenchmarkClient* client : generator->clients()) {
+            const std::vector<RouteStats>& stats = client->stats();
+            for (size_t r = 0; r < stats.size(); ++r) {
+                routeTotals[r].latenciesNs.insert(routeTotals[r].latenciesNs.end(),
+                                                  stats[r].latenciesNs.begin(), stats[r].latenciesNs.end());
+                routeTotals[r].errors += stats[r].errors;
+            }
+        }
+    }
+
+    RouteStats handshakes;
+    for (LoadGenerator* generator : generators) {
+        for (BenchmarkClient* client : generator->clients()) {
+            const RouteStats& stats = client->handshakeStats();
+            handshakes.latenciesNs.insert(handshakes.latenciesNs.end(),
+                                          stats.latenciesNs.begin(), stats.latenciesNs.end());
+            handshakes.errors += stats.errors;
+        }
+    }
+
+    RouteStats overall;
+    auto printRow = [&out, durationSecs](const QString& label, RouteStats& stats) {
+        std::sort(stats.latenciesNs.begin(), stats.latenciesNs.end());
+        auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 3); };
+        out << qSetFieldWidth(40) << Qt::left << label << qSetFieldWidth(0)
+            << " 请求 " << stats.latenciesNs.size()
+            << "  错误 " << stats.errors
+            << "  rps " << QString::number(double(stats.latenciesNs.size()) / durationSecs, 'f', 1)
+            << "  p50 " << ms(percentile(stats.latenciesNs, 0.50))
+            << "  p90 " << ms(percentile(stats.latenciesNs, 0.90))
+            << "  p99 " << ms(percentile(stats.latenciesNs, 0.99))
+            << "  p999 " << ms(percentile(stats.latenciesNs, 0.999))
+            << " (ms)\n";
+    };
+
+    for (size_t r = 0; r < config.routes.size(); ++r) {
+        overall.latenciesNs.insert(overall.latenciesNs.end(),
+                                   routeTotals[r].latenciesNs.begin(), routeTotals[r].latenciesNs.end());
+        overall.errors += routeTotals[r].errors;
+        printRow(config.routes[r].label, routeTotals[r]);
+    }
+    printRow("总计", overall);
+    if (!handshakes.latenciesNs.empty() || handshakes.errors > 0) {
+        printRow("TLS握手", handshakes);
+    }
+
+    for (LoadGenerator* generator : generators) {
+        delete generator;
+    }
+    server.close();
+    return overall.errors > 0 && overall.latenciesNs.empty() ? 1 : 0;
+}
+
+#include "HttpBenchmark.moc"
@@ -0,0 +1,95 @@
+#include "HttpBodyStream.h"
+#include <QMutexLocker>
+
+void HttpBodyStream::State::notifyLocked()
+{
+    if (!notifyPending && notifier) {
+        notifyPending = true;
+        notifier();
+    }
+}
+
+bool HttpBodyStream::Writer::write(const QByteArray& chunk)
+{
+    QMutexLocker locker(&m_state->mutex);
+    while (!m_state->cancelled && m_state->chunks.size() >= m_state->maxQueuedChunks) {
+        m_state->notFull.wait(&m_state->mutex);
+    }
+    if (m_state->cancelled) {
+        return false;
+    }
+    if (!chunk.isEmpty()) {
+        m_state->chunks.enqueue(chunk);
+        m_state->notifyLocked();
+    }
+    return true;
+}
+
+void HttpBodyStream::Writer::finish()
+{
+    QMutexLocker locker(&m_state->mutex);
+    m_state->finished = true;
+    m_state->notifyLocked();
+}
+
+void HttpBodyStream::Writer::fail()
+{
+    QMutexLocker locker(&m_state->mutex);
+    m_state->finished = true;
+    m_state->failed = true;
+    m_state->notifyLocked();
+}
+
+HttpBodyStream::HttpBodyStream(int maxQueuedChunks)
+    : m_state(std::make_shared<State>())
+{
+    m_state->maxQueuedChunks = qMax(1, maxQueuedChunks);
+}
+
+HttpBodyStream::~HttpBodyStream()
+{
+    // 消费方放弃：唤醒可能阻塞在write中的生产方
+    QMutexLocker locker(&m_state->mutex);
+    m_state->cancelled = true;
+    m_state->notifier = nullptr;
+    m_state->chunks.clear();
+    m_state->notFull.wakeAll();
+}
+
+bool HttpBodyStream::read(QByteArray& chunk)
+{
+    QMutexLocker locker(&m_state->mutex);
+    if (m_state->chunks.isEmpty()) {
+        // 取空后允许下一次通知
+        m_state->notifyPending = false;
+        return false;
+    }
+    chunk = m_state->chunks.dequeue();
+    m_state->notFull.wakeOne();
+    return true;
+}
+
+bool HttpBodyStream::isReady() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return !m_state->chunks.isEmpty() || m_state->finished;
+}
+
+bool HttpBodyStream::atEnd() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->finished && m_state->chunks.isEmpty();
+}
+
+bool HttpBodyStream::failed() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->failed;
+}
+
+void HttpBodyStream::setNotifier(std::function<void()> notifier)
+{
+    QMutexLocker locker(&m_state->mutex);
+    m_state->notifier = std::move(notifier);
+    m_state->notifyPending = false;
+}
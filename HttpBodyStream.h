@@ -0,0 +1,76 @@
+#ifndef HTTPBODYSTREAM_H
+#define HTTPBODYSTREAM_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+
+// 流式响应体：后台线程逐块生产，连接所在线程逐块取走并以chunked编码写出。
+// 队列有界，生产方在队列满时阻塞；连接只在套接字写缓冲区低于水位时取数据，
+// 因此套接字写不动时压力会一路传回生产方（例如暂停读取数据库游标）。
+// 响应持有本对象，最后一个引用释放（连接关闭）时生产方的写入立即返回false
+class HttpBodyStream
+{
+    struct State;
+
+public:
+    // 生产方句柄，可复制，在生产线程使用
+    class Writer
+    {
+    public:
+        // 写入一块数据，队列满时阻塞；消费方已放弃时返回false，生产方应停止
+        bool write(const QByteArray& chunk);
+        // 正常结束
+        void finish();
+        // 生产失败：尚未写出任何数据时连接改为回复500，否则中断连接
+        void fail();
+
+    private:
+        friend class HttpBodyStream;
+        explicit Writer(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+        std::shared_ptr<State> m_state;
+    };
+
+    explicit HttpBodyStream(int maxQueuedChunks = 8);
+    ~HttpBodyStream();
+
+    HttpBodyStream(const HttpBodyStream&) = delete;
+    HttpBodyStream& operator=(const HttpBodyStream&) = delete;
+
+    Writer writer() const { return Writer(m_state); }
+
+    // 以下由消费方（连接）调用
+    // 取出一块数据，暂无数据时返回false
+    bool read(QByteArray& chunk);
+    // 是否已有可读数据或已结束（可以开始写响应头）
+    bool isReady() const;
+    // 生产已结束且数据已全部取走
+    bool atEnd() const;
+    bool failed() const;
+    // 有新数据或结束时的通知回调（在生产线程调用，取空之前只通知一次）；
+    // 回调应只做投递（如排队调用），不能再访问本对象
+    void setNotifier(std::function<void()> notifier);
+
+private:
+    struct State {
+        mutable QMutex mutex;
+        QWaitCondition notFull;
+        QQueue<QByteArray> chunks;
+        int maxQueuedChunks = 8;
+        bool finished = false;
+        bool failed = false;
+        bool cancelled = false;
+        bool notifyPending = false;
+        std::function<void()> notifier;
+
+        // 调用方已持有锁
+        void notifyLocked();
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // HTTPBODYSTREAM_H
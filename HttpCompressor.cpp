@@ -0,0 +1,124 @@
+#include "HttpCompressor.h"
+#include <QStringList>
+#include <QThread>
+#include <QDebug>
+#include <zlib.h>
+
+HttpCompressor::Encoding HttpCompressor::negotiate(const QString& acceptEncoding)
+{
+    if (acceptEncoding.isEmpty()) {
+        return Encoding::Identity;
+    }
+
+    double gzipQ = -1.0;
+    double deflateQ = -1.0;
+    double wildcardQ = -1.0;
+
+    const QStringList codings = acceptEncoding.split(',', Qt::SkipEmptyParts);
+    for (const QString& entry : codings) {
+        const QStringList parts = entry.split(';');
+        const QString coding = parts.first().trimmed().toLower();
+
+        // 解析q值，缺省为1
+        double q = 1.0;
+        for (int i = 1; i < parts.size(); ++i) {
+            const QString param = parts.at(i).trimmed();
+            if (param.startsWith("q=", Qt::CaseInsensitive)) {
+                bool ok = false;
+                double value = param.mid(2).toDouble(&ok);
+                q = ok ? value : 0.0;
+            }
+        }
+
+        if (coding == "gzip" || coding == "x-gzip") {
+            gzipQ = q;
+        } else if (coding == "deflate") {
+            deflateQ = q;
+        } else if (coding == "*") {
+            wildcardQ = q;
+        }
+    }
+
+    // 未单独列出的编码使用通配符的q值
+    if (gzipQ < 0) {
+        gzipQ = wildcardQ;
+    }
+    if (deflateQ < 0) {
+        deflateQ = wildcardQ;
+    }
+
+    if (gzipQ > 0 && gzipQ >= deflateQ) {
+        return Encoding::Gzip;
+    }
+    if (deflateQ > 0) {
+        return Encoding::Deflate;
+    }
+    return Encoding::Identity;
+}
+
+const char* HttpCompressor::encodingName(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Gzip:
+        return "gzip";
+    case Encoding::Deflate:
+        return "deflate";
+    default:
+        return "identity";
+    }
+}
+
+bool HttpCompressor::isCompressible(const QString& contentType)
+{
+    return contentType.startsWith("application/json", Qt::CaseInsensitive)
+        || contentType.startsWith("text/", Qt::CaseInsensitive)
+        || contentType.contains("xml", Qt::CaseInsensitive)
+        || contentType.contains("javascript", Qt::CaseInsensitive);
+}
+
+QByteArray HttpCompressor::compress(const QByteArray& data, Encoding encoding, int level)
+{
+    if (encoding == Encoding::Identity) {
+        return QByteArray();
+    }
+
+    z_stream stream = {};
+    // windowBits加16输出gzip封装；HTTP的deflate编码指zlib封装格式
+    int windowBits = encoding == Encoding::Gzip ? MAX_WBITS + 16 : MAX_WBITS;
+    if (deflateInit2(&stream, qBound(1, level, 9), Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        qWarning() << "zlib初始化失败";
+        return QByteArray();
+    }
+
+    // 按上界一次分配输出缓冲区，单次deflate即可完成
+    QByteArray output;
+    output.resize(static_cast<qsizetype>(deflateBound(&stream, static_cast<uLong>(data.size()))));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    int result = deflate(&stream, Z_FINISH);
+    qsizetype compressedSize = static_cast<qsizetype>(stream.total_out);
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        qWarning() << "zlib压缩失败，错误码:" << result;
+        return QByteArray();
+    }
+
+    output.resize(compressedSize);
+    return output;
+}
+
+QThreadPool* HttpCompressor::threadPool()
+{
+    static QThreadPool* pool = []() {
+        QThreadPool* p = new QThreadPool();
+        p->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+        p->setExpiryTimeout(30000);
+        return p;
+    }();
+    return pool;
+}
@@ -0,0 +1,45 @@
+#ifndef HTTPCOMPRESSOR_H
+#define HTTPCOMPRESSOR_H
+
+#include <QByteArray>
+#include <QString>
+#include <QThreadPool>
+
+// 响应体压缩设置
+struct HttpCompressionSettings {
+    bool enabled = true;
+    // 小于此大小的响应体不压缩（压缩收益抵不过开销）
+    int minSize = 1024;
+    // zlib压缩级别 1-9
+    int level = 6;
+    // 不小于此大小的响应体交给压缩线程池，不占用连接所在的事件循环
+    int offloadThreshold = 64 * 1024;
+};
+
+// 基于zlib的HTTP内容编码：Accept-Encoding协商与gzip/deflate压缩
+class HttpCompressor
+{
+public:
+    enum class Encoding {
+        Identity,
+        Gzip,
+        Deflate
+    };
+
+    // 按Accept-Encoding（含q值）选择编码，gzip与deflate同权重时优先gzip
+    static Encoding negotiate(const QString& acceptEncoding);
+
+    // Content-Encoding头部的取值
+    static const char* encodingName(Encoding encoding);
+
+    // 文本类内容才值得压缩（JSON、text/*、XML、JavaScript）
+    static bool isCompressible(const QString& contentType);
+
+    // 一次性压缩，失败时返回空数组
+    static QByteArray compress(const QByteArray& data, Encoding encoding, int level);
+
+    // 大响应体压缩使用的线程池，与图像处理使用的全局线程池分开
+    static QThreadPool* threadPool();
+};
+
+#endif // HTTPCOMPRESSOR_H
@@ -0,0 +1,1076 @@
+#include "HttpConnection.h"
+#include "MultipartStreamParser.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+#include "Metrics.h"
+#include <array>
+
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#include <cerrno>
+#endif
+
+namespace {
+// 文件响应体每次写入套接字缓冲区的块大小（映射/读取路径），以及单次sendfile的上限
+const qint64 kFileChunkSize = 64 * 1024;
+const qint64 kSendfileChunkSize = 1024 * 1024;
+// 批量类请求体（如大文件上传）每轮事件循环最多读取的字节数
+const qint64 kBulkReadSlice = 256 * 1024;
+// 套接字读缓冲区上限：暂停读取期间缓冲区满后不再从内核取数据，由TCP窗口阻止客户端继续发送
+const qint64 kSocketReadBufferSize = 512 * 1024;
+
+// 连接级指标，首次使用时注册
+struct ConnectionMetrics {
+    MetricGauge* active;
+    MetricCounter* opened;
+    MetricCounter* bytesIn;
+    MetricCounter* bytesOut;
+};
+
+const ConnectionMetrics& connectionMetrics()
+{
+    static const ConnectionMetrics metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        return ConnectionMetrics{
+            registry.gauge("http_active_connections", "Open HTTP connections"),
+            registry.counter("http_connections_total", "Accepted HTTP connections"),
+            registry.counter("http_received_bytes_total", "Bytes read from HTTP clients"),
+            registry.counter("http_sent_bytes_total", "Bytes written to HTTP clients"),
+        };
+    }();
+    return metrics;
+}
+
+// 按路由类别的指标：从请求接收完毕到响应全部交给套接字的时间，以及在线程池中排队的时间
+struct ClassMetrics {
+    MetricHistogram* latency;
+    MetricHistogram* queueWait;
+};
+
+const ClassMetrics& classMetrics(HttpAdmissionController::RouteClass routeClass)
+{
+    using RouteClass = HttpAdmissionController::RouteClass;
+    static const std::array<ClassMetrics, static_cast<int>(RouteClass::Count)> metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        std::array<ClassMetrics, static_cast<int>(RouteClass::Count)> result;
+        for (int i = 0; i < static_cast<int>(result.size()); ++i) {
+            const QByteArray labels = MetricsRegistry::label(
+                "class", HttpAdmissionController::routeClassName(static_cast<RouteClass>(i)));
+            result[i].latency = registry.histogram("http_class_request_duration_seconds",
+                                                   "Time from request received to response written, by request class",
+                                                   labels);
+            result[i].queueWait = registry.histogram("http_class_queue_wait_seconds",
+                                                     "Time spent queued for a pool thread, by request class", labels);
+        }
+        return result;
+    }();
+    return metrics[static_cast<int>(routeClass)];
+}
+}
+
+HttpConnection::HttpConnection(QTcpSocket* socket, RequestHandler* requestHandler,
+                               HttpAdmissionController* admission,
+                               const HttpConnectionSettings& settings, QObject* parent)
+    : QObject(parent),
+      m_socket(socket),
+      m_requestHandler(requestHandler),
+      m_admission(admission),
+      m_settings(settings),
+      m_clientAddress(socket->peerAddress().toString())
+{
+    // 套接字随连接对象一起释放
+    m_socket->setParent(this);
+
+    m_parser.setLimits(m_settings.parserLimits);
+    m_socket->setReadBufferSize(kSocketReadBufferSize);
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(m_settings.keepAliveTimeoutMs);
+    connect(&m_idleTimer, &QTimer::timeout, this, &HttpConnection::onIdleTimeout);
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &HttpConnection::readClient);
+    connect(m_socket, &QTcpSocket::bytesWritten, this, [this](qint64 bytes) {
+        connectionMetrics().bytesOut->inc(static_cast<quint64>(bytes));
+        // 写缓冲区腾出空间后继续推送积压的事件或响应体
+        if (m_eventStream) {
+            flushEvents();
+        } else if (m_bodyStream) {
+            m_idleTimer.start();
+            pumpBodyStream();
+        } else if (m_file) {
+            m_idleTimer.start();
+            pumpFileBody();
+        }
+    });
+
+    connectionMetrics().opened->inc();
+    connectionMetrics().active->add(1);
+    connect(m_socket, &QTcpSocket::disconnected, this, &HttpConnection::discardClient);
+
+    // 连接建立后若迟迟没有请求，同样按空闲超时处理
+    m_idleTimer.start();
+}
+
+HttpConnection::~HttpConnection()
+{
+    m_idleTimer.stop();
+
+    if (m_awaitingResponse) {
+        qDebug() << "连接关闭时仍有未完成的响应，结果将被丢弃:" << m_clientAddress;
+    }
+    // 仍在等待名额时撤销，此后不会再收到回调；已投递的回调随本对象一起移除，名额随之归还
+    if (m_waitId != 0) {
+        m_admission->cancelWait(m_routeClass, m_waitId);
+    }
+    connectionMetrics().active->add(-1);
+
+    // 返回后发布线程不会再调用通知回调，已投递的调用随本对象一起移除
+    if (m_eventStream) {
+        m_eventStream->setNotifier(nullptr);
+    }
+    // 释放最后一个引用后阻塞在写入中的生产方会被唤醒并停止
+    if (m_bodyStream) {
+        m_bodyStream->setNotifier(nullptr);
+    }
+}
+
+bool HttpConnection::wantsKeepAlive(const QString& version, const HttpHeaders& headers) const
+{
+    const QByteArrayView connectionHeader = headers.value(HttpHeaders::Connection);
+
+    // HTTP/1.1默认保持连接，除非客户端明确要求关闭
+    if (version.compare("HTTP/1.1", Qt::CaseInsensitive) == 0) {
+        return !HttpHeaders::containsIgnoreCase(connectionHeader, "close");
+    }
+
+    // HTTP/1.0需要显式的keep-alive
+    return HttpHeaders::containsIgnoreCase(connectionHeader, "keep-alive");
+}
+
+void HttpConnection::onIdleTimeout()
+{
+    if (m_eventStream) {
+        // 事件流连接空闲时发送SSE注释行作为心跳
+        m_socket->write(":\n\n", 3);
+        m_idleTimer.start();
+        return;
+    }
+
+    if (m_bodyStream) {
+        if (m_socket->bytesToWrite() == 0) {
+            // 生产方仍在查询，客户端没有积压，继续等待
+            m_idleTimer.start();
+            return;
+        }
+        // 客户端长时间不读取数据，中断连接以释放生产方占用的线程
+        qWarning() << "流式响应发送停滞，中断连接:" << m_clientAddress;
+        m_closing = true;
+        m_socket->abort();
+        return;
+    }
+
+    if (m_file) {
+        // 每次有进展都会重新计时，超时说明客户端已停止读取
+        qWarning() << "文件响应发送停滞，中断连接:" << m_clientAddress;
+        m_closing = true;
+        m_socket->abort();
+        return;
+    }
+
+    qDebug() << "连接空闲超时，关闭:" << m_socket->peerAddress().toString();
+    m_closing = true;
+    m_socket->disconnectFromHost();
+}
+
+void HttpConnection::readClient()
+{
+    m_readPending = false;
+
+    if (m_eventStream) {
+        // 事件流连接上客户端不应再发送请求，丢弃收到的数据
+        connectionMetrics().bytesIn->inc(static_cast<quint64>(m_socket->readAll().size()));
+        return;
+    }
+
+    // 响应未完成时不取数据，留在有上限的套接字读缓冲区中，恢复读取时再解析
+    if (m_readPaused) {
+        return;
+    }
+
+    // 有新数据到达，暂停空闲计时（流式响应期间计时器用于检测发送停滞）
+    if (!m_bodyStream && !m_file) {
+        m_idleTimer.stop();
+    }
+
+    // 只取走当前已到达的数据，不足一个完整请求时等待下一次readyRead。
+    // 批量类请求体每轮只取一片，剩余数据在下一轮事件循环继续读取，
+    // 同一工作线程上其他连接的交互类请求不必等整批上传数据写完
+    const bool sliced = m_routeClass == HttpAdmissionController::RouteClass::Bulk && m_parser.readingBody();
+    QByteArray data = sliced ? m_socket->read(kBulkReadSlice) : m_socket->readAll();
+    connectionMetrics().bytesIn->inc(static_cast<quint64>(data.size()));
+    m_parser.append(data);
+
+    // 下一个请求的数据开始到达的时间，头部解析完毕时计入"http.read_headers"
+    if (m_traceArrivalNs == 0 && RequestTracer::instance().enabled()) {
+        m_traceArrivalNs = RequestTracer::nowNs();
+    }
+
+    try {
+        processBufferedRequests();
+    } catch (const std::exception& e) {
+        qCritical() << "处理客户端请求时发生异常:" << e.what();
+        sendErrorResponse(500, "Internal Server Error");
+    } catch (...) {
+        qCritical() << "处理客户端请求时发生未知异常";
+        sendErrorResponse(500, "Internal Server Error");
+    }
+
+    // 慢速上传期间每收到一批数据都会重新计时，数据停止到达才会超时
+    if (!m_closing && !m_awaitingResponse && m_socket->state() == QTcpSocket::ConnectedState) {
+        m_idleTimer.start();
+    }
+
+    // 已到达的数据不会再触发readyRead，排到事件队列末尾继续读取
+    if (sliced && !m_closing && !m_readPending && m_socket->bytesAvailable() > 0) {
+        m_readPending = true;
+        QMetaObject::invokeMethod(this, [this]() { readClient(); }, Qt::QueuedConnection);
+    }
+}
+
+void HttpConnection::processBufferedRequests()
+{
+    // 流水线请求：缓冲区中可能包含多个请求，按到达顺序依次处理，
+    // 由于每个请求处理完才解析下一个，响应顺序与请求顺序一致
+    while (!m_closing && !m_awaitingResponse) {
+        HttpRequestParser::Result result = m_parser.parse();
+
+        if (result == HttpRequestParser::Result::NeedMoreData) {
+            return;
+        }
+
+        if (result == HttpRequestParser::Result::HeadersReady) {
+            if (!handleHeadersReady()) {
+                return;
+            }
+            continue;
+        }
+
+        if (result == HttpRequestParser::Result::Error) {
+            // 请求边界已不可信，回复错误后关闭连接
+            sendErrorResponse(m_parser.errorStatus(), m_parser.errorMessage());
+            return;
+        }
+
+        bool keepAlive = handleParsedRequest();
+        m_parser.reset();
+        if (!keepAlive) {
+            return;
+        }
+        // 已在缓冲区中的流水线请求从此刻开始计时
+        if (m_traceArrivalNs == 0 && m_parser.hasBufferedData() && RequestTracer::instance().enabled()) {
+            m_traceArrivalNs = RequestTracer::nowNs();
+        }
+    }
+}
+
+bool HttpConnection::handleHeadersReady()
+{
+    // 分配请求ID，随请求对象传给处理函数和数据库层
+    m_trace = RequestTracer::instance().beginRequest();
+    m_parser.request().trace = m_trace;
+    if (m_trace.sampled) {
+        m_traceHeadersNs = RequestTracer::nowNs();
+        m_traceStartNs = m_traceArrivalNs != 0 ? m_traceArrivalNs : m_traceHeadersNs;
+        RequestTracer::instance().record(m_trace, "http.read_headers", m_traceStartNs, m_traceHeadersNs);
+    }
+    m_traceArrivalNs = 0;
+
+    const RequestHandler::HttpRequest& request = m_parser.request();
+    const qint64 declaredBodySize = m_parser.declaredBodySize();
+
+    // 只认识100-continue，其它期望无法满足
+    const QByteArrayView expect = request.headers.value(HttpHeaders::Expect);
+    if (!expect.isEmpty() && !HttpHeaders::equalsIgnoreCase(expect, "100-continue")) {
+        sendResponse(m_requestHandler->createErrorResponse(417, "Expectation Failed"), false);
+        return false;
+    }
+
+    // 超限或类型不符时在请求体到达之前回复，连接随后关闭（未读取的请求体不再接收）
+    RequestHandler::BodyPolicy policy;
+    RequestHandler::HttpResponse rejection;
+    m_routeClass = HttpAdmissionController::RouteClass::Default;
+    if (!m_requestHandler->precheckRequest(request, declaredBodySize, policy, m_routeClass, rejection)) {
+        sendResponse(rejection, false);
+        return false;
+    }
+    if (policy.maxBodySize >= 0) {
+        m_parser.setBodySizeLimit(policy.maxBodySize);
+    }
+
+    // 路由要求写入临时文件的请求体（文件上传）不经过内存，其余请求体保存在内存中
+    if (policy.streamToFile) {
+        const QByteArrayView contentType = request.headers.value(HttpHeaders::ContentType);
+        if (HttpHeaders::containsIgnoreCase(contentType, "multipart/form-data")) {
+            QByteArray boundary = MultipartStreamParser::boundaryFromContentType(QString::fromLatin1(contentType));
+            if (boundary.isEmpty()) {
+                qWarning() << "无法从Content-Type提取boundary";
+            } else {
+                qDebug() << "检测到multipart/form-data上传，边界:" << boundary;
+                auto sink = std::make_unique<MultipartStreamParser>(boundary);
+                sink->setRequiredPrefix(policy.magic);
+                m_parser.setBodySink(std::move(sink));
+            }
+        } else {
+            // 文件头在收到开头几个字节时即检查，不符合时不必等整个请求体传完
+            auto sink = std::make_unique<TempFileBodySink>();
+            sink->setRequiredPrefix(policy.magic);
+            m_parser.setBodySink(std::move(sink));
+        }
+    }
+
+    // 请求体去向确定后按最终上限检查声明的长度（保存在内存中的请求体还受内存上限限制），
+    // 不会先回复100 Continue、等客户端传完请求体再回复413
+    if (declaredBodySize > m_parser.bodySizeLimit()) {
+        sendResponse(m_requestHandler->createErrorResponse(413, "Payload Too Large"), false);
+        return false;
+    }
+
+    // 限速检查同样在请求体到达之前进行，名额和等待队列都已满时也在此拒绝，
+    // 被拒绝的请求不再上传请求体、不占用内存或临时文件。处理中名额在请求体接收完毕后才占用
+    if (m_admission) {
+        RequestTracer::Span span(m_trace, "http.admission");
+        HttpAdmissionController::Decision decision = m_admission->checkRequest(m_clientAddress, m_routeClass);
+        if (decision != HttpAdmissionController::Decision::Admit) {
+            // 请求体（如有）未读取，回复后关闭连接
+            sendResponse(admissionRejection(decision, request.path), false);
+            return false;
+        }
+    }
+
+    // 客户端在等待确认后才发送请求体；已经开始发送时不再回复
+    if (!expect.isEmpty() && declaredBodySize != 0 && !m_parser.hasBufferedData()
+        && m_parser.httpVersion().compare("HTTP/1.1", Qt::CaseInsensitive) == 0) {
+        m_socket->write("HTTP/1.1 100 Continue\r\n\r\n");
+    }
+
+    return true;
+}
+
+bool HttpConnection::handleParsedRequest()
+{
+    RequestHandler::HttpRequest& request = m_parser.request();
+    m_requestStartNs = RequestTracer::nowNs();
+    if (m_trace.sampled) {
+        RequestTracer::instance().record(m_trace, "http.read_body", m_traceHeadersNs, m_requestStartNs);
+    }
+
+    // 每个请求只输出这一行摘要，解析器不再逐行、逐个头部输出
+    qDebug() << "收到HTTP请求来自:" << m_clientAddress
+             << "请求:" << request.method << request.path
+             << "头部数:" << request.headers.size() << "请求体:" << m_parser.bodyBytesReceived() << "字节";
+
+    // 修正Content-Length头（上传文件已写入磁盘时为文件大小）
+    if (request.uploadedFile) {
+        request.headers.set("Content-Length", QByteArray::number(request.uploadedFile->size()));
+    } else if (!request.body.isEmpty()) {
+        request.headers.set("Content-Length", QByteArray::number(request.body.size()));
+    }
+
+    // 决定本次响应后是否保持连接
+    m_requestCount++;
+    bool keepAlive = wantsKeepAlive(m_parser.httpVersion(), request.headers)
+                     && m_requestCount < m_settings.maxRequestsPerConnection;
+    // 线程池中完成的响应发送时解析器已重置，协议版本在此记下
+    m_chunkedAllowed = m_parser.httpVersion().compare("HTTP/1.1", Qt::CaseInsensitive) == 0;
+
+    // 请求体已接收完毕，取得处理中名额；名额用完时进入等待队列，期间不处理后续流水线请求
+    HttpAdmissionController::Ticket ticket;
+    if (m_admission) {
+        HttpAdmissionController::Decision decision;
+        {
+            RequestTracer::Span span(m_trace, "http.admission");
+            decision = m_admission->acquireSlot(m_routeClass, ticket,
+                                                [this](HttpAdmissionController::Ticket granted) {
+                auto shared = std::make_shared<HttpAdmissionController::Ticket>(std::move(granted));
+                QMetaObject::invokeMethod(this, [this, shared]() {
+                    onSlotGranted(std::move(*shared));
+                }, Qt::QueuedConnection);
+            }, m_waitId);
+        }
+        if (decision == HttpAdmissionController::Decision::Overloaded) {
+            // 请求体已读完，可以保持连接
+            sendResponse(admissionRejection(decision, request.path), keepAlive);
+            return keepAlive;
+        }
+        if (decision == HttpAdmissionController::Decision::Queued) {
+            m_awaitingResponse = true;
+            pauseReading();
+            m_idleTimer.stop();
+            m_queuedKeepAlive = keepAlive;
+            m_queuedSinceNs = RequestTracer::nowNs();
+            // 解析器随后重置，请求对象移出保存
+            m_queuedRequest = std::move(request);
+            return keepAlive;
+        }
+    }
+
+    return executeRequest(request, keepAlive, std::move(ticket));
+}
+
+void HttpConnection::onSlotGranted(HttpAdmissionController::Ticket ticket)
+{
+    m_waitId = 0;
+    m_awaitingResponse = false;
+    if (m_trace.sampled) {
+        RequestTracer::instance().record(m_trace, "http.admission_wait", m_queuedSinceNs, RequestTracer::nowNs());
+    }
+
+    RequestHandler::HttpRequest request = std::move(m_queuedRequest);
+    m_queuedRequest = RequestHandler::HttpRequest();
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        qDebug() << "排队的请求取得名额时客户端已断开:" << m_clientAddress;
+        finishRequest();
+        return;
+    }
+
+    const bool proceed = executeRequest(request, m_queuedKeepAlive, std::move(ticket));
+    if (proceed && !m_awaitingResponse) {
+        resumeAfterAsyncResponse();
+    }
+}
+
+RequestHandler::HttpResponse HttpConnection::admissionRejection(HttpAdmissionController::Decision decision,
+                                                                const QString& path) const
+{
+    const bool rateLimited = decision == HttpAdmissionController::Decision::RateLimited;
+    qWarning() << (rateLimited ? "请求过于频繁，拒绝:" : "服务繁忙，拒绝:") << m_clientAddress << path;
+    RequestHandler::HttpResponse rejection = rateLimited
+        ? m_requestHandler->createErrorResponse(429, "Too Many Requests")
+        : m_requestHandler->createErrorResponse(503, "Service Unavailable");
+    rejection.headers.insert("Retry-After", "1");
+    return rejection;
+}
+
+bool HttpConnection::executeRequest(RequestHandler::HttpRequest& request, bool keepAlive,
+                                    HttpAdmissionController::Ticket ticket)
+{
+    const QString acceptEncoding = QString::fromLatin1(request.headers.value(HttpHeaders::AcceptEncoding));
+
+    if (m_routeClass == HttpAdmissionController::RouteClass::Bulk) {
+        // 批量类请求连处理函数也在批量线程池执行，工作线程只负责收发数据。
+        // 请求移入任务，连接随后会重置解析器，不再使用它
+        RequestHandler* handler = m_requestHandler;
+        runInPool([handler, request = std::move(request)]() {
+            RequestHandler::HttpResponse response;
+            try {
+                RequestTracer::Scope scope(request.trace);
+                response = handler->handleRequest(request);
+                // 已在批量线程池中，延迟部分直接执行
+                if (response.deferred) {
+                    std::function<RequestHandler::HttpResponse()> work = std::move(response.deferred);
+                    response = work();
+                }
+            } catch (...) {
+                qCritical() << "处理请求时发生未捕获的异常";
+                response = handler->createErrorResponse(500, "Internal Server Error");
+            }
+            return response;
+        }, acceptEncoding, keepAlive, std::make_shared<HttpAdmissionController::Ticket>(std::move(ticket)));
+        return keepAlive;
+    }
+
+    // 交互类请求在工作线程上直接处理
+    RequestHandler::HttpResponse response;
+    try {
+        // 同步处理函数中调用的数据库查询同样记到本请求下
+        RequestTracer::Scope scope(m_trace);
+        response = m_requestHandler->handleRequest(request);
+    } catch (...) {
+        qCritical() << "处理请求时发生未捕获的异常";
+        sendErrorResponse(500, "Internal Server Error");
+        return false;
+    }
+
+    return dispatchResponse(std::move(response), acceptEncoding, keepAlive, std::move(ticket));
+}
+
+bool HttpConnection::dispatchResponse(RequestHandler::HttpResponse response, const QString& acceptEncoding,
+                                      bool keepAlive, HttpAdmissionController::Ticket ticket)
+{
+    if (response.eventStream) {
+        // 连接转为事件流，后续流水线请求不再处理
+        startEventStream(response);
+        return false;
+    }
+
+    if (response.bodyStream) {
+        // 流式响应体不压缩，边生产边发送
+        startBodyStream(std::move(response), m_chunkedAllowed, keepAlive,
+                        std::make_shared<HttpAdmissionController::Ticket>(std::move(ticket)));
+        return keepAlive;
+    }
+
+    if (response.file) {
+        // 文件响应体不压缩（媒体文件本身已压缩），直接从文件发送
+        startFileBody(std::move(response), keepAlive,
+                      std::make_shared<HttpAdmissionController::Ticket>(std::move(ticket)));
+        return keepAlive;
+    }
+
+    if (response.deferred) {
+        // 处理中名额在延迟响应完成前一直占用
+        std::function<RequestHandler::HttpResponse()> work = std::move(response.deferred);
+        runInPool(std::move(work), acceptEncoding, keepAlive,
+                  std::make_shared<HttpAdmissionController::Ticket>(std::move(ticket)));
+        return keepAlive;
+    }
+
+    // 发送HTTP响应；压缩交给线程池时处理中名额同样占用到响应写出
+    compressAndSend(acceptEncoding, std::move(response), keepAlive,
+                    std::make_shared<HttpAdmissionController::Ticket>(std::move(ticket)));
+    return keepAlive;
+}
+
+void HttpConnection::runInPool(std::function<RequestHandler::HttpResponse()> work, const QString& acceptEncoding,
+                               bool keepAlive, std::shared_ptr<HttpAdmissionController::Ticket> ticket)
+{
+    // 完成前不处理后续流水线请求，保证响应顺序；也不按空闲超时关闭。
+    // 期间暂停读取套接字，结果写出后由resumeAfterAsyncResponse恢复
+    m_awaitingResponse = true;
+    pauseReading();
+    m_idleTimer.stop();
+
+    // 观察者随连接对象释放：客户端中途断开时结果直接丢弃，不会写入已删除的套接字。
+    // ticket由回调持有，回调释放时归还处理中名额
+    QFutureWatcher<RequestHandler::HttpResponse>* watcher =
+        new QFutureWatcher<RequestHandler::HttpResponse>(this);
+    connect(watcher, &QFutureWatcher<RequestHandler::HttpResponse>::finished, this,
+            [this, watcher, acceptEncoding, keepAlive, ticket]() {
+        watcher->deleteLater();
+        m_awaitingResponse = false;
+
+        if (m_socket->state() != QTcpSocket::ConnectedState) {
+            qDebug() << "延迟响应完成时客户端已断开，丢弃结果:" << m_clientAddress;
+            // 请求到此结束：归还名额，记录类别耗时和追踪
+            *ticket = HttpAdmissionController::Ticket();
+            finishRequest();
+            return;
+        }
+
+        const bool proceed = dispatchResponse(watcher->result(), acceptEncoding, keepAlive, std::move(*ticket));
+        if (proceed && !m_awaitingResponse) {
+            resumeAfterAsyncResponse();
+        }
+    });
+
+    const HttpAdmissionController::RouteClass routeClass = m_routeClass;
+    const qint64 queuedNs = RequestTracer::nowNs();
+    watcher->setFuture(QtConcurrent::run(m_requestHandler->deferredPool(routeClass),
+                                         [work = std::move(work), routeClass, queuedNs]() {
+        classMetrics(routeClass).queueWait->observeNanoseconds(RequestTracer::nowNs() - queuedNs);
+        return work();
+    }));
+}
+
+void HttpConnection::pauseReading()
+{
+    m_readPaused = true;
+}
+
+void HttpConnection::resumeReading()
+{
+    m_readPaused = false;
+    // 暂停期间到达的数据已在读缓冲区中，不会再次触发readyRead
+    if (!m_closing && !m_readPending && m_socket->bytesAvailable() > 0) {
+        m_readPending = true;
+        QMetaObject::invokeMethod(this, [this]() { readClient(); }, Qt::QueuedConnection);
+    }
+}
+
+void HttpConnection::resumeAfterAsyncResponse()
+{
+    // 先排队读取暂停期间到达的数据；下面的流水线请求若再次进入异步响应会重新暂停，排队的读取随之放弃
+    resumeReading();
+
+    // 继续处理等待期间到达的流水线请求
+    try {
+        if (!m_closing) {
+            processBufferedRequests();
+        }
+    } catch (const std::exception& e) {
+        qCritical() << "处理客户端请求时发生异常:" << e.what();
+        sendErrorResponse(500, "Internal Server Error");
+    } catch (...) {
+        qCritical() << "处理客户端请求时发生未知异常";
+        sendErrorResponse(500, "Internal Server Error");
+    }
+
+    if (!m_closing && !m_awaitingResponse && m_socket->state() == QTcpSocket::ConnectedState) {
+        m_idleTimer.start();
+    }
+}
+
+void HttpConnection::compressAndSend(const QString& acceptEncoding, RequestHandler::HttpResponse response,
+                                     bool keepAlive, std::shared_ptr<HttpAdmissionController::Ticket> ticket)
+{
+    const HttpCompressionSettings& settings = m_settings.compression;
+    bool compressible = settings.enabled
+                        && response.content.size() >= settings.minSize
+                        && response.statusCode != 204 && response.statusCode != 304
+                        && !response.headers.contains("Content-Encoding")
+                        && HttpCompressor::isCompressible(response.contentType);
+    if (!compressible) {
+        sendResponse(response, keepAlive);
+        return;
+    }
+
+    // 响应内容随Accept-Encoding变化，缓存需区分
+    response.headers.insert("Vary", "Accept-Encoding");
+
+    HttpCompressor::Encoding encoding = HttpCompressor::negotiate(acceptEncoding);
+    if (encoding == HttpCompressor::Encoding::Identity) {
+        sendResponse(response, keepAlive);
+        return;
+    }
+
+    // 压缩结果比原文小时才替换响应体
+    auto applyCompressed = [encoding](RequestHandler::HttpResponse& target, const QByteArray& compressed) {
+        if (!compressed.isEmpty() && compressed.size() < target.content.size()) {
+            target.content = compressed;
+            target.headers.insert("Content-Encoding", HttpCompressor::encodingName(encoding));
+            // 压缩后的字节序列与原文不同，强校验器加上编码后缀（"…-gzip"），两种表示不共用一个ETag；
+            // RequestHandler::etagMatches比较时去掉该后缀
+            auto etag = target.headers.find("ETag");
+            if (etag != target.headers.end() && etag->endsWith('"') && !etag->startsWith("W/")) {
+                etag->insert(etag->size() - 1, QLatin1Char('-') + QLatin1String(HttpCompressor::encodingName(encoding)));
+            }
+        }
+    };
+
+    if (response.content.size() < settings.offloadThreshold) {
+        RequestTracer::Span span(m_trace, "http.compress");
+        applyCompressed(response, HttpCompressor::compress(response.content, encoding, settings.level));
+        sendResponse(response, keepAlive);
+        return;
+    }
+
+    // 大响应体交给压缩线程池，事件循环继续服务本线程上的其他连接
+    m_awaitingResponse = true;
+    pauseReading();
+    m_idleTimer.stop();
+
+    QFutureWatcher<QByteArray>* watcher = new QFutureWatcher<QByteArray>(this);
+    connect(watcher, &QFutureWatcher<QByteArray>::finished, this,
+            [this, watcher, response, keepAlive, applyCompressed, ticket]() mutable {
+        watcher->deleteLater();
+        applyCompressed(response, watcher->result());
+        m_awaitingResponse = false;
+
+        sendResponse(response, keepAlive);
+        // 先归还名额，再处理流水线中的下一个请求
+        ticket.reset();
+        resumeAfterAsyncResponse();
+    });
+
+    QByteArray content = response.content;
+    int level = settings.level;
+    watcher->setFuture(QtConcurrent::run(HttpCompressor::threadPool(), [content, encoding, level, trace = m_trace]() {
+        RequestTracer::Span span(trace, "http.compress");
+        return HttpCompressor::compress(content, encoding, level);
+    }));
+}
+
+void HttpConnection::discardClient()
+{
+    qDebug() << "连接关闭，客户端:" << m_socket->peerAddress().toString()
+             << "，共处理请求:" << m_requestCount;
+
+    m_closing = true;
+    m_idleTimer.stop();
+
+    emit closed(this);
+
+    // 安全删除，而不是直接删除
+    deleteLater();
+}
+
+void HttpConnection::sendResponse(const RequestHandler::HttpResponse& response, bool keepAlive)
+{
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        qWarning() << "无法发送响应：套接字无效或未连接";
+        // 响应虽未发出，请求同样到此结束
+        finishRequest();
+        return;
+    }
+
+    try {
+        RequestTracer::Span span(m_trace, "http.write");
+        // 状态行和头部渲染到可复用缓冲区，小响应体一并写出
+        int keepAliveMax = keepAlive ? m_settings.maxRequestsPerConnection - m_requestCount : -1;
+        bool bodyInlined = m_responseWriter.render(response, m_settings.keepAliveTimeoutMs / 1000, keepAliveMax);
+        m_socket->write(m_responseWriter.buffer());
+
+        // 大响应体单独追加到套接字写缓冲区，避免再复制一次
+        if (!bodyInlined) {
+            qint64 bytesWritten = m_socket->write(response.content);
+            if (bytesWritten != response.content.size()) {
+                qWarning() << "写入的字节数与内容长度不匹配:"
+                          << bytesWritten << "vs" << response.content.size();
+            }
+        }
+
+        if (!keepAlive) {
+            // disconnectFromHost会在待发送数据写完后再关闭
+            m_closing = true;
+            m_socket->disconnectFromHost();
+        }
+    } catch (const std::exception& e) {
+        qCritical() << "发送响应时发生异常:" << e.what();
+    } catch (...) {
+        qCritical() << "发送响应时发生未知异常";
+    }
+    finishRequest();
+}
+
+void HttpConnection::startEventStream(const RequestHandler::HttpResponse& response)
+{
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    m_responseWriter.render(response, 0, 0, HttpResponseWriter::BodyFraming::Stream);
+    m_socket->write(m_responseWriter.buffer());
+
+    m_eventStream = response.eventStream;
+    m_idleTimer.setInterval(m_settings.eventStreamHeartbeatMs);
+    // 请求到事件流建立为止，此后的推送不属于该请求
+    finishRequest();
+
+    // 回调在发布线程执行，只投递到本连接所在线程
+    m_eventStream->setNotifier([this]() {
+        QMetaObject::invokeMethod(this, "flushEvents", Qt::QueuedConnection);
+    });
+    qDebug() << "事件流已建立，客户端:" << m_socket->peerAddress().toString();
+
+    // 订阅时补发的最新状态
+    flushEvents();
+}
+
+void HttpConnection::flushEvents()
+{
+    if (!m_eventStream || m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    // 慢客户端：暂不取出事件，新事件在订阅者缓冲区中按丢弃最旧策略累积
+    if (m_socket->bytesToWrite() > m_settings.eventStreamMaxBacklog) {
+        return;
+    }
+
+    const QList<QByteArray> events = m_eventStream->takeAll();
+    for (const QByteArray& event : events) {
+        m_socket->write(event);
+    }
+}
+
+void HttpConnection::startBodyStream(RequestHandler::HttpResponse response, bool chunked, bool keepAlive,
+                                     std::shared_ptr<HttpAdmissionController::Ticket> ticket)
+{
+    // 发送完成前不处理后续流水线请求；处理中名额一直占用到响应体发送完毕
+    m_awaitingResponse = true;
+    pauseReading();
+    m_bodyStream = response.bodyStream;
+    m_bodyStreamResponse = std::move(response);
+    m_bodyStreamTicket = std::move(ticket);
+    m_bodyStreamChunked = chunked;
+    // 不支持chunked的客户端以关闭连接标志响应体结束
+    m_bodyStreamKeepAlive = keepAlive && chunked;
+    m_bodyStreamHeadWritten = false;
+
+    // 空闲计时器改为检测发送停滞
+    m_idleTimer.start();
+
+    // 回调在生产线程执行，只投递到本连接所在线程
+    m_bodyStream->setNotifier([this]() {
+        QMetaObject::invokeMethod(this, "pumpBodyStream", Qt::QueuedConnection);
+    });
+
+    // 设置回调之前已生产的数据：排队处理，当前仍在处理流水线请求的循环中，不能在此重入
+    QMetaObject::invokeMethod(this, "pumpBodyStream", Qt::QueuedConnection);
+}
+
+void HttpConnection::pumpBodyStream()
+{
+    if (!m_bodyStream || m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    if (!m_bodyStreamHeadWritten) {
+        // 等到有数据或已结束再写响应头，生产方一开始就失败时还能回复错误状态码
+        if (!m_bodyStream->isReady()) {
+            return;
+        }
+        if (m_bodyStream->failed()) {
+            qWarning() << "流式响应生产失败，改为回复500:" << m_clientAddress;
+            bool keepAlive = m_bodyStreamKeepAlive;
+            finishBodyStream();
+            sendResponse(m_requestHandler->createErrorResponse(500, "Internal Server Error"), keepAlive);
+            resumeAfterAsyncResponse();
+            return;
+        }
+
+        int keepAliveMax = m_bodyStreamKeepAlive ? m_settings.maxRequestsPerConnection - m_requestCount : -1;
+        m_responseWriter.render(m_bodyStreamResponse, m_settings.keepAliveTimeoutMs / 1000, keepAliveMax,
+                                m_bodyStreamChunked ? HttpResponseWriter::BodyFraming::Chunked
+                                                    : HttpResponseWriter::BodyFraming::Stream);
+        m_socket->write(m_responseWriter.buffer());
+        m_bodyStreamHeadWritten = true;
+    }
+
+    // 写缓冲区超过水位时暂停取数据，bytesWritten时继续
+    QByteArray chunk;
+    while (m_socket->bytesToWrite() < m_settings.bodyStreamHighWatermark && m_bodyStream->read(chunk)) {
+        if (m_bodyStreamChunked) {
+            m_socket->write(HttpResponseWriter::chunkHeader(chunk.size()));
+            m_socket->write(chunk);
+            m_socket->write("\r\n", 2);
+        } else {
+            m_socket->write(chunk);
+        }
+    }
+
+    if (!m_bodyStream->atEnd()) {
+        return;
+    }
+
+    if (m_bodyStream->failed()) {
+        // 响应头已发出，只能中断连接，客户端据此得知响应不完整
+        qWarning() << "流式响应中途失败，中断连接:" << m_clientAddress;
+        finishBodyStream();
+        m_closing = true;
+        m_socket->abort();
+        return;
+    }
+
+    if (m_bodyStreamChunked) {
+        m_socket->write(HttpResponseWriter::lastChunk());
+    }
+
+    bool keepAlive = m_bodyStreamKeepAlive;
+    finishBodyStream();
+    if (!keepAlive) {
+        m_closing = true;
+        m_socket->disconnectFromHost();
+        return;
+    }
+    resumeAfterAsyncResponse();
+}
+
+void HttpConnection::finishBodyStream()
+{
+    m_bodyStream->setNotifier(nullptr);
+    m_bodyStream.reset();
+    m_bodyStreamResponse = RequestHandler::HttpResponse();
+    m_bodyStreamTicket.reset();
+    m_awaitingResponse = false;
+    m_idleTimer.stop();
+    resumeReading();
+    finishRequest();
+}
+
+void HttpConnection::startFileBody(RequestHandler::HttpResponse response, bool keepAlive,
+                                   std::shared_ptr<HttpAdmissionController::Ticket> ticket)
+{
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    int keepAliveMax = keepAlive ? m_settings.maxRequestsPerConnection - m_requestCount : -1;
+    m_responseWriter.render(response, m_settings.keepAliveTimeoutMs / 1000, keepAliveMax);
+    m_socket->write(m_responseWriter.buffer());
+
+    if (response.fileLength <= 0) {
+        finishRequest();
+        if (!keepAlive) {
+            m_closing = true;
+            m_socket->disconnectFromHost();
+        }
+        return;
+    }
+
+    // 发送完成前不处理后续流水线请求；处理中名额一直占用到文件发送完毕
+    m_awaitingResponse = true;
+    pauseReading();
+    m_file = std::move(response.file);
+    m_fileOffset = response.fileOffset;
+    m_fileRemaining = response.fileLength;
+    m_fileTicket = std::move(ticket);
+    m_fileKeepAlive = keepAlive;
+
+    // 映射失败（例如特殊文件系统）时退回按块读取
+    m_fileMapBase = m_fileOffset;
+    m_fileMap = m_file->map(m_fileOffset, m_fileRemaining);
+
+    // 空闲计时器改为检测发送停滞
+    m_idleTimer.start();
+
+    // 响应头还在写缓冲区中，排队开始发送；当前仍在处理流水线请求的循环中，不能在此重入
+    QMetaObject::invokeMethod(this, "pumpFileBody", Qt::QueuedConnection);
+}
+
+bool HttpConnection::sendFileDirect()
+{
+#ifdef Q_OS_LINUX
+    const int socketFd = static_cast<int>(m_socket->socketDescriptor());
+    const int fileFd = m_file->handle();
+    while (m_fileRemaining > 0) {
+        off_t offset = static_cast<off_t>(m_fileOffset);
+        ssize_t sent = ::sendfile(socketFd, fileFd, &offset,
+                                  static_cast<size_t>(qMin(m_fileRemaining, kSendfileChunkSize)));
+        if (sent > 0) {
+            m_fileOffset += sent;
+            m_fileRemaining -= sent;
+            // 绕过了套接字缓冲区，不会触发bytesWritten，在此计数和重新计时
+            connectionMetrics().bytesOut->inc(static_cast<quint64>(sent));
+            m_idleTimer.start();
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 内核发送缓冲区已满：交给下面的写缓冲区路径写一块，
+            // 由套接字在可写时发出bytesWritten，再回到这里继续
+            return true;
+        }
+        qWarning() << "sendfile失败，中断连接:" << m_clientAddress << (sent < 0 ? errno : 0);
+        finishFileBody();
+        m_closing = true;
+        m_socket->abort();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void HttpConnection::pumpFileBody()
+{
+    if (!m_file || m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    // 写缓冲区已排空时才能直接写描述符，否则会和缓冲区中的数据乱序；TLS连接需要加密，不能绕过套接字
+    if (m_socket->bytesToWrite() == 0 && !m_socket->inherits("QSslSocket")) {
+        if (!sendFileDirect()) {
+            return;
+        }
+    }
+#endif
+
+    // 写缓冲区超过水位时暂停，bytesWritten时继续
+    while (m_fileRemaining > 0 && m_socket->bytesToWrite() < m_settings.bodyStreamHighWatermark) {
+        const qint64 size = qMin(m_fileRemaining, kFileChunkSize);
+        if (m_fileMap) {
+            m_socket->write(reinterpret_cast<const char*>(m_fileMap + (m_fileOffset - m_fileMapBase)), size);
+        } else {
+            QByteArray chunk;
+            if (m_file->seek(m_fileOffset)) {
+                chunk = m_file->read(size);
+            }
+            if (chunk.isEmpty()) {
+                // 响应头已发出，只能中断连接，客户端据此得知响应不完整
+                qWarning() << "读取媒体文件失败，中断连接:" << m_file->fileName() << m_file->errorString();
+                finishFileBody();
+                m_closing = true;
+                m_socket->abort();
+                return;
+            }
+            m_socket->write(chunk);
+        }
+        m_fileOffset += size;
+        m_fileRemaining -= size;
+#ifdef Q_OS_LINUX
+        // sendfile遇到EAGAIN后只写一块，作为可写通知的来源
+        if (!m_socket->inherits("QSslSocket")) {
+            break;
+        }
+#endif
+    }
+
+    if (m_fileRemaining > 0) {
+        return;
+    }
+
+    bool keepAlive = m_fileKeepAlive;
+    finishFileBody();
+    if (!keepAlive) {
+        m_closing = true;
+        m_socket->disconnectFromHost();
+        return;
+    }
+    resumeAfterAsyncResponse();
+}
+
+void HttpConnection::finishFileBody()
+{
+    if (m_fileMap) {
+        m_file->unmap(m_fileMap);
+        m_fileMap = nullptr;
+    }
+    m_file.reset();
+    m_fileTicket.reset();
+    m_fileRemaining = 0;
+    m_awaitingResponse = false;
+    m_idleTimer.stop();
+    resumeReading();
+    finishRequest();
+}
+
+void HttpConnection::finishRequest()
+{
+    // 请求在头部阶段被拒绝时没有开始时间，不计入类别延迟
+    if (m_requestStartNs != 0 || m_trace.sampled) {
+        const qint64 nowNs = RequestTracer::nowNs();
+        if (m_requestStartNs != 0) {
+            classMetrics(m_routeClass).latency->observeNanoseconds(nowNs - m_requestStartNs);
+        }
+        if (m_trace.sampled) {
+            RequestTracer::instance().record(m_trace, "http.request", m_traceStartNs, nowNs);
+        }
+    }
+    m_requestStartNs = 0;
+    m_trace = RequestTracer::Context();
+}
+
+void HttpConnection::sendErrorResponse(int statusCode, const QString& message)
+{
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        return;
+    }
+
+    try {
+        RequestHandler::HttpResponse errorResponse;
+        errorResponse.statusCode = statusCode;
+        errorResponse.statusMessage = message;
+        errorResponse.contentType = "application/json";
+
+        // 创建简单的错误JSON
+        QJsonObject errorObj;
+        errorObj["error"] = true;
+        errorObj["message"] = message;
+        errorObj["status"] = statusCode;
+        QJsonDocument doc(errorObj);
+        errorResponse.content = doc.toJson();
+
+        // 出错后请求边界不可信，关闭连接
+        sendResponse(errorResponse, false);
+    } catch (...) {
+        qCritical() << "发送错误响应时发生异常";
+        m_closing = true;
+        m_socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,194 @@
+#ifndef HTTPCONNECTION_H
+#define HTTPCONNECTION_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QMap>
+#include "Requesthandler.h"
+#include "HttpRequestParser.h"
+#include "HttpResponseWriter.h"
+#include "HttpCompressor.h"
+#include "HttpAdmissionController.h"
+
+// 连接级别的配置（由HttpServer统一下发）
+struct HttpConnectionSettings {
+    // 空闲超时：两次请求之间允许的最长静默时间
+    int keepAliveTimeoutMs = 15000;
+    // 单个连接最多处理的请求数，达到后响应带Connection: close
+    int maxRequestsPerConnection = 100;
+    // 事件流连接的心跳间隔，防止中间代理因静默断开连接
+    int eventStreamHeartbeatMs = 15000;
+    // 事件流写缓冲区积压超过此值时暂停推送（慢客户端），由订阅者缓冲区丢弃旧事件
+    qint64 eventStreamMaxBacklog = 256 * 1024;
+    // 流式响应体：写缓冲区低于此值时才取下一块，客户端读得慢时生产方随之暂停
+    qint64 bodyStreamHighWatermark = 256 * 1024;
+    // 请求行/头部/请求体大小上限
+    HttpRequestParser::Limits parserLimits;
+    // 响应体压缩
+    HttpCompressionSettings compression;
+};
+
+// 单个客户端连接：持有套接字，负责读取请求、按顺序写回响应，
+// 并维护HTTP/1.1持久连接（keep-alive）状态
+class HttpConnection : public QObject
+{
+    Q_OBJECT
+public:
+    HttpConnection(QTcpSocket* socket, RequestHandler* requestHandler, HttpAdmissionController* admission,
+                   const HttpConnectionSettings& settings, QObject* parent = nullptr);
+    ~HttpConnection();
+
+    QTcpSocket* socket() const { return m_socket; }
+
+signals:
+    // 连接关闭（对象随后会被deleteLater）
+    void closed(HttpConnection* connection);
+
+private slots:
+    void readClient();
+    void discardClient();
+    void onIdleTimeout();
+    // 把订阅者缓冲区中的事件写到套接字
+    void flushEvents();
+    // 把流式响应体中已生产的数据块写到套接字
+    void pumpBodyStream();
+    // 继续发送文件响应体
+    void pumpFileBody();
+
+private:
+    QTcpSocket* m_socket;
+    RequestHandler* m_requestHandler;
+    HttpAdmissionController* m_admission;
+    HttpConnectionSettings m_settings;
+    // 对端地址，用于按客户端限速
+    QString m_clientAddress;
+
+    // 增量解析器，跨多次readyRead保存解析进度
+    HttpRequestParser m_parser;
+    // 响应序列化缓冲区，连接内复用
+    HttpResponseWriter m_responseWriter;
+
+    // 空闲计时器：响应写完后启动，收到新数据时停止
+    QTimer m_idleTimer;
+    // 本连接已处理的请求数
+    int m_requestCount = 0;
+    // 已决定关闭连接，后续流水线请求不再处理
+    bool m_closing = false;
+    // 正在线程池中执行延迟响应或压缩响应，完成前不处理后续流水线请求，保证响应顺序
+    bool m_awaitingResponse = false;
+    // 非空表示连接已切换为事件流
+    std::shared_ptr<EventSubscriber> m_eventStream;
+    // 非空表示正在发送流式响应体，发送完成前不处理后续流水线请求
+    std::shared_ptr<HttpBodyStream> m_bodyStream;
+    RequestHandler::HttpResponse m_bodyStreamResponse;
+    std::shared_ptr<HttpAdmissionController::Ticket> m_bodyStreamTicket;
+    bool m_bodyStreamChunked = true;
+    bool m_bodyStreamKeepAlive = false;
+    bool m_bodyStreamHeadWritten = false;
+    // 非空表示正在发送文件响应体，发送完成前不处理后续流水线请求
+    std::shared_ptr<QFile> m_file;
+    // 文件区间的内存映射（映射失败时为空，改为按块读取）及其对应的文件偏移
+    uchar* m_fileMap = nullptr;
+    qint64 m_fileMapBase = 0;
+    // 下一个待发送字节的文件偏移和剩余字节数
+    qint64 m_fileOffset = 0;
+    qint64 m_fileRemaining = 0;
+    std::shared_ptr<HttpAdmissionController::Ticket> m_fileTicket;
+    bool m_fileKeepAlive = false;
+
+    // 请求追踪：当前请求的上下文，以及下一个请求首批数据到达、当前请求开始和头部解析完毕的时间
+    RequestTracer::Context m_trace;
+    qint64 m_traceArrivalNs = 0;
+    qint64 m_traceStartNs = 0;
+    qint64 m_traceHeadersNs = 0;
+
+    // 当前请求匹配路由的类别（请求头到达时确定）及请求接收完毕的时间
+    HttpAdmissionController::RouteClass m_routeClass = HttpAdmissionController::RouteClass::Default;
+    // 当前请求为HTTP/1.1，流式响应体可以使用chunked编码
+    bool m_chunkedAllowed = true;
+    qint64 m_requestStartNs = 0;
+    // 等待处理中名额的请求（请求体已接收完毕）及其等待编号（0表示没有在等待）
+    RequestHandler::HttpRequest m_queuedRequest;
+    bool m_queuedKeepAlive = false;
+    qint64 m_queuedSinceNs = 0;
+    quint64 m_waitId = 0;
+    // 批量类请求体分片读取或恢复读取时，已排队的下一次readClient
+    bool m_readPending = false;
+    // 有响应未完成（延迟响应、压缩、流式响应体、文件）时暂停读取套接字，
+    // 流水线或恶意客户端不能让解析器缓冲区无限增长
+    bool m_readPaused = false;
+
+
+    // 根据协议版本和Connection头部判断是否保持连接
+    bool wantsKeepAlive(const QString& version, const HttpHeaders& headers) const;
+
+    // 处理解析器缓冲区中所有已完整的请求
+    void processBufferedRequests();
+
+    // 头部解析完毕：按路由的请求体限制预检并做准入检查（不合格时立即回复413/415/417/429/503
+    // 并返回false），处理Expect: 100-continue，并决定请求体是留在内存还是流式写入临时文件
+    bool handleHeadersReady();
+
+    // 处理一个已解析完成的请求，返回false表示连接将关闭
+    bool handleParsedRequest();
+    // 已取得处理中名额：批量类交给线程池，其余在工作线程上直接处理
+    bool executeRequest(RequestHandler::HttpRequest& request, bool keepAlive,
+                        HttpAdmissionController::Ticket ticket);
+    // 排队的请求取得名额（在本连接所在线程调用）
+    void onSlotGranted(HttpAdmissionController::Ticket ticket);
+    // 限速或过载时的429/503响应
+    RequestHandler::HttpResponse admissionRejection(HttpAdmissionController::Decision decision,
+                                                    const QString& path) const;
+
+    // 按响应类型发送：事件流、流式响应体、文件、延迟响应或普通响应；
+    // 返回false表示本连接不再处理后续请求
+    bool dispatchResponse(RequestHandler::HttpResponse response, const QString& acceptEncoding,
+                          bool keepAlive, HttpAdmissionController::Ticket ticket);
+
+    // 按Accept-Encoding压缩响应体后发送；大响应体在压缩线程池中处理，
+    // ticket持有到压缩完成、响应写出之后
+    void compressAndSend(const QString& acceptEncoding, RequestHandler::HttpResponse response,
+                         bool keepAlive, std::shared_ptr<HttpAdmissionController::Ticket> ticket);
+
+    // 在当前请求类别的线程池中执行work（延迟响应，或批量类请求的整个处理过程），
+    // 完成后在本连接所在线程发送结果
+    void runInPool(std::function<RequestHandler::HttpResponse()> work, const QString& acceptEncoding,
+                   bool keepAlive, std::shared_ptr<HttpAdmissionController::Ticket> ticket);
+
+    // 异步响应写出后恢复读取，继续处理缓冲区中的请求并恢复空闲计时
+    void resumeAfterAsyncResponse();
+
+    // 暂停/恢复读取套接字：暂停期间数据留在套接字读缓冲区，恢复时排队读取已到达的数据
+    void pauseReading();
+    void resumeReading();
+
+    // 发送HTTP响应，keepAlive为false时写完后关闭连接
+    void sendResponse(const RequestHandler::HttpResponse& response, bool keepAlive);
+
+    // 写出事件流响应头，此后连接只用于推送事件
+    void startEventStream(const RequestHandler::HttpResponse& response);
+
+    // 开始发送流式响应体；chunked为false（HTTP/1.0客户端）时以关闭连接结束响应体
+    void startBodyStream(RequestHandler::HttpResponse response, bool chunked, bool keepAlive,
+                         std::shared_ptr<HttpAdmissionController::Ticket> ticket);
+    // 流式响应体结束，释放相关状态
+    void finishBodyStream();
+
+    // 写出响应头并开始发送文件区间：明文连接用sendfile由内核直接从页缓存发送，
+    // TLS连接（或sendfile不可用时）从内存映射按块写入套接字
+    void startFileBody(RequestHandler::HttpResponse response, bool keepAlive,
+                       std::shared_ptr<HttpAdmissionController::Ticket> ticket);
+    // sendfile推进文件区间，返回false表示套接字出错（连接已中断）
+    bool sendFileDirect();
+    // 文件响应体结束，释放相关状态
+    void finishFileBody();
+
+    // 响应已全部交给套接字：记录类别延迟和整个请求的追踪区间，清除追踪上下文
+    void finishRequest();
+
+    // 发送错误响应（总是关闭连接）
+    void sendErrorResponse(int statusCode, const QString& message);
+};
+
+#endif // HTTPCONNECTION_H
@@ -0,0 +1,171 @@
+#include "HttpHeaders.h"
+#include <cstring>
+
+namespace {
+struct KnownName {
+    const char* name;
+    qsizetype length;
+    quint32 hash;
+};
+
+constexpr KnownName known(const char* name, qsizetype length)
+{
+    return KnownName{name, length, HttpHeaders::hashName(name, length)};
+}
+
+#define AR_KNOWN_HEADER(literal) known(literal, sizeof(literal) - 1)
+
+// 顺序与HttpHeaders::Known一致
+constexpr KnownName kKnownNames[] = {
+    AR_KNOWN_HEADER("Content-Length"),
+    AR_KNOWN_HEADER("Content-Type"),
+    AR_KNOWN_HEADER("Transfer-Encoding"),
+    AR_KNOWN_HEADER("Connection"),
+    AR_KNOWN_HEADER("Expect"),
+    AR_KNOWN_HEADER("Accept-Encoding"),
+    AR_KNOWN_HEADER("Host"),
+    AR_KNOWN_HEADER("User-Agent"),
+    AR_KNOWN_HEADER("Range"),
+    AR_KNOWN_HEADER("If-Range"),
+    AR_KNOWN_HEADER("If-None-Match"),
+    AR_KNOWN_HEADER("If-Modified-Since"),
+};
+
+#undef AR_KNOWN_HEADER
+
+static_assert(sizeof(kKnownNames) / sizeof(kKnownNames[0]) == HttpHeaders::KnownCount,
+              "kKnownNames must match HttpHeaders::Known");
+
+inline char foldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+}
+
+HttpHeaders::HttpHeaders()
+{
+    m_known.fill(-1);
+}
+
+void HttpHeaders::reserve(qsizetype bytes)
+{
+    m_raw.reserve(bytes);
+}
+
+int HttpHeaders::storeBytes(QByteArrayView bytes)
+{
+    const int offset = static_cast<int>(m_raw.size());
+    m_raw.append(bytes.data(), bytes.size());
+    return offset;
+}
+
+void HttpHeaders::append(QByteArrayView name, QByteArrayView value)
+{
+    Entry entry;
+    entry.hash = hashName(name.data(), name.size());
+    entry.nameLength = static_cast<int>(name.size());
+    entry.nameOffset = storeBytes(name);
+    entry.valueLength = static_cast<int>(value.size());
+    entry.valueOffset = storeBytes(value);
+
+    const int index = static_cast<int>(m_entries.size());
+    m_entries.append(entry);
+
+    for (int k = 0; k < KnownCount; ++k) {
+        if (kKnownNames[k].hash == entry.hash
+            && equalsIgnoreCase(name, QByteArrayView(kKnownNames[k].name, kKnownNames[k].length))) {
+            m_known[k] = static_cast<qint16>(index);
+            break;
+        }
+    }
+}
+
+void HttpHeaders::set(QByteArrayView name, QByteArrayView value)
+{
+    const int index = find(name, hashName(name.data(), name.size()));
+    if (index < 0) {
+        append(name, value);
+        return;
+    }
+    // 旧值留在缓冲区中不再引用
+    Entry& entry = m_entries[index];
+    entry.valueLength = static_cast<int>(value.size());
+    entry.valueOffset = storeBytes(value);
+}
+
+int HttpHeaders::find(QByteArrayView name, quint32 hash) const
+{
+    for (int i = static_cast<int>(m_entries.size()) - 1; i >= 0; --i) {
+        const Entry& entry = m_entries[i];
+        if (entry.hash == hash && equalsIgnoreCase(view(entry.nameOffset, entry.nameLength), name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QByteArrayView HttpHeaders::value(Known key) const
+{
+    const int index = m_known[key];
+    if (index < 0) {
+        return QByteArrayView();
+    }
+    const Entry& entry = m_entries[index];
+    return view(entry.valueOffset, entry.valueLength);
+}
+
+QByteArrayView HttpHeaders::value(QByteArrayView name) const
+{
+    const int index = find(name, hashName(name.data(), name.size()));
+    if (index < 0) {
+        return QByteArrayView();
+    }
+    const Entry& entry = m_entries[index];
+    return view(entry.valueOffset, entry.valueLength);
+}
+
+QString HttpHeaders::text(Known key, const QString& defaultValue) const
+{
+    if (!contains(key)) {
+        return defaultValue;
+    }
+    return QString::fromUtf8(value(key));
+}
+
+QByteArrayView HttpHeaders::nameAt(int index) const
+{
+    const Entry& entry = m_entries[index];
+    return view(entry.nameOffset, entry.nameLength);
+}
+
+QByteArrayView HttpHeaders::valueAt(int index) const
+{
+    const Entry& entry = m_entries[index];
+    return view(entry.valueOffset, entry.valueLength);
+}
+
+bool HttpHeaders::equalsIgnoreCase(QByteArrayView a, QByteArrayView b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (qsizetype i = 0; i < a.size(); ++i) {
+        if (foldCase(a.data()[i]) != foldCase(b.data()[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpHeaders::containsIgnoreCase(QByteArrayView haystack, QByteArrayView needle)
+{
+    if (needle.isEmpty()) {
+        return true;
+    }
+    for (qsizetype i = 0; i + needle.size() <= haystack.size(); ++i) {
+        if (equalsIgnoreCase(QByteArrayView(haystack.data() + i, needle.size()), needle)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+#ifndef HTTPHEADERS_H
+#define HTTPHEADERS_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+#include <array>
+
+// 请求头存储：所有头部的名称和值依次拷贝到同一个缓冲区，按偏移量索引，
+// 查询结果是指向该缓冲区的QByteArrayView，不为每个头部分配QString。
+// 名称按ASCII小写折叠后散列；常用头部（Content-Length等）在加入时即记下位置，
+// 按Known查询为O(1)。同名头部出现多次时以最后一个为准（与原QMap行为一致）。
+// 返回的视图在本对象（或共享同一缓冲区的副本）被修改或销毁前有效
+class HttpHeaders
+{
+public:
+    enum Known {
+        ContentLength,
+        ContentType,
+        TransferEncoding,
+        Connection,
+        Expect,
+        AcceptEncoding,
+        Host,
+        UserAgent,
+        Range,
+        IfRange,
+        IfNoneMatch,
+        IfModifiedSince,
+        KnownCount
+    };
+
+    HttpHeaders();
+
+    // 追加一个头部，name和value应已去除首尾空白
+    void append(QByteArrayView name, QByteArrayView value);
+    // 替换同名头部的值，不存在时追加
+    void set(QByteArrayView name, QByteArrayView value);
+    // 为头部名称和值预留存储空间（字节数），由解析器按实际收到的头部大小调用
+    void reserve(qsizetype bytes);
+
+    QByteArrayView value(Known key) const;
+    QByteArrayView value(QByteArrayView name) const;
+    bool contains(Known key) const { return m_known[key] >= 0; }
+
+    // 值的QString副本（按UTF-8解码），用于日志及需要QString的旧接口
+    QString text(Known key, const QString& defaultValue = QString()) const;
+
+    int size() const { return static_cast<int>(m_entries.size()); }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    QByteArrayView nameAt(int index) const;
+    QByteArrayView valueAt(int index) const;
+
+    // 折叠大小写的FNV-1a散列，常用头部的散列在编译期算出
+    static constexpr quint32 hashName(const char* data, qsizetype size)
+    {
+        quint32 hash = 2166136261u;
+        for (qsizetype i = 0; i < size; ++i) {
+            char c = data[i];
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c + ('a' - 'A'));
+            }
+            hash = (hash ^ static_cast<quint8>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    // ASCII大小写不敏感的比较与子串查找（头部值的关键字匹配）
+    static bool equalsIgnoreCase(QByteArrayView a, QByteArrayView b);
+    static bool containsIgnoreCase(QByteArrayView haystack, QByteArrayView needle);
+
+private:
+    struct Entry {
+        int nameOffset;
+        int nameLength;
+        int valueOffset;
+        int valueLength;
+        quint32 hash;
+    };
+
+    QByteArrayView view(int offset, int length) const
+    {
+        return QByteArrayView(m_raw.constData() + offset, length);
+    }
+    int storeBytes(QByteArrayView bytes);
+    int find(QByteArrayView name, quint32 hash) const;
+
+    QByteArray m_raw;
+    // 常见请求的头部数量不超过16个，不需要额外分配
+    QVarLengthArray<Entry, 16> m_entries;
+    // 常用头部在m_entries中的下标，-1表示不存在
+    std::array<qint16, KnownCount> m_known;
+};
+
+#endif // HTTPHEADERS_H
@@ -0,0 +1,409 @@
+#include "HttpRequestParser.h"
+#include <QUrlQuery>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+namespace {
+// 按Content-Length预留内存的上限，更大的请求体随数据到达逐步扩容
+const qint64 kMaxInitialBodyReserve = 64 * 1024;
+
+inline bool isHeaderSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+// 去除首尾空格和制表符
+QByteArrayView trimmedView(QByteArrayView bytes)
+{
+    qsizetype begin = 0;
+    qsizetype end = bytes.size();
+    while (begin < end && isHeaderSpace(bytes.data()[begin])) {
+        ++begin;
+    }
+    while (end > begin && isHeaderSpace(bytes.data()[end - 1])) {
+        --end;
+    }
+    return QByteArrayView(bytes.data() + begin, end - begin);
+}
+
+// 解析十进制的Content-Length，非数字或溢出时返回false
+bool parseContentLength(QByteArrayView value, qint64& length)
+{
+    if (value.isEmpty()) {
+        return false;
+    }
+    qint64 result = 0;
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        const char c = value.data()[i];
+        if (c < '0' || c > '9' || result > (std::numeric_limits<qint64>::max() - 9) / 10) {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    length = result;
+    return true;
+}
+
+// 解析十六进制的块大小，只接受十六进制数字（不允许符号和"0x"前缀），溢出时返回false
+bool parseChunkSize(QByteArrayView value, qint64& size)
+{
+    if (value.isEmpty()) {
+        return false;
+    }
+    qint64 result = 0;
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        const char c = value.data()[i];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (result > (std::numeric_limits<qint64>::max() - digit) / 16) {
+            return false;
+        }
+        result = result * 16 + digit;
+    }
+    size = result;
+    return true;
+}
+}
+
+HttpRequestParser::HttpRequestParser()
+{
+}
+
+void HttpRequestParser::append(const QByteArray& data)
+{
+    // 已消费的数据较多时先压缩缓冲区，避免大请求体期间缓冲区无限增长
+    if (m_offset > 0 && (m_offset == m_buffer.size() || m_offset > 64 * 1024)) {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(data);
+}
+
+void HttpRequestParser::reset()
+{
+    m_buffer.remove(0, m_offset);
+    m_offset = 0;
+
+    m_request = RequestHandler::HttpRequest();
+    m_version.clear();
+    m_headerBytes = 0;
+    m_bodyRemaining = 0;
+    m_bodyReceived = 0;
+    m_bodySizeLimit = -1;
+    m_bodySink.reset();
+    m_errorStatus = 0;
+    m_errorMessage.clear();
+    m_state = State::RequestLine;
+}
+
+void HttpRequestParser::fail(int status, const QString& message)
+{
+    qWarning() << "HTTP请求解析失败:" << status << message;
+    m_errorStatus = status;
+    m_errorMessage = message;
+    m_state = State::Error;
+}
+
+bool HttpRequestParser::takeLine(QByteArrayView& line, int maxLength)
+{
+    qsizetype newline = m_buffer.indexOf('\n', m_offset);
+    if (newline < 0) {
+        // 没有完整的一行，超过长度限制则判定为错误
+        if (m_buffer.size() - m_offset > maxLength) {
+            fail(m_state == State::RequestLine ? 414 : 431,
+                 m_state == State::RequestLine ? "URI Too Long" : "Request Header Fields Too Large");
+        }
+        return false;
+    }
+
+    qsizetype length = newline - m_offset;
+    if (length > maxLength) {
+        fail(m_state == State::RequestLine ? 414 : 431,
+             m_state == State::RequestLine ? "URI Too Long" : "Request Header Fields Too Large");
+        return false;
+    }
+
+    if (length > 0 && m_buffer.at(newline - 1) == '\r') {
+        --length;
+    }
+    line = QByteArrayView(m_buffer.constData() + m_offset, length);
+    m_offset = newline + 1;
+    return true;
+}
+
+bool HttpRequestParser::parseRequestLine(const QByteArray& line)
+{
+    QList<QByteArray> tokens;
+    for (const QByteArray& token : line.split(' ')) {
+        if (!token.isEmpty()) {
+            tokens.append(token);
+        }
+    }
+
+    if (tokens.size() < 2) {
+        fail(400, "Bad Request");
+        return false;
+    }
+
+    m_request.method = QString::fromLatin1(tokens[0]);
+    m_version = tokens.size() > 2 ? QString::fromLatin1(tokens[2]) : QString("HTTP/1.0");
+
+    const QByteArray& target = tokens[1];
+    int queryPos = target.indexOf('?');
+    m_request.path = QString::fromUtf8(queryPos < 0 ? target : target.left(queryPos));
+
+    // 解析查询参数
+    if (queryPos >= 0) {
+        QUrlQuery urlQuery(QString::fromUtf8(target.mid(queryPos + 1)));
+        const QList<QPair<QString, QString>> items = urlQuery.queryItems();
+        for (const auto& item : items) {
+            m_request.query[item.first] = item.second;
+        }
+    }
+    return true;
+}
+
+bool HttpRequestParser::parseHeaderLine(QByteArrayView line)
+{
+    const char* separator = static_cast<const char*>(std::memchr(line.data(), ':', line.size()));
+    if (!separator || separator == line.data()) {
+        fail(400, "Bad Request");
+        return false;
+    }
+
+    const qsizetype separatorIndex = separator - line.data();
+    const QByteArrayView key = trimmedView(QByteArrayView(line.data(), separatorIndex));
+    const QByteArrayView value = trimmedView(QByteArrayView(separator + 1, line.size() - separatorIndex - 1));
+    m_request.headers.append(key, value);
+    return true;
+}
+
+bool HttpRequestParser::beginBody()
+{
+    const QByteArrayView contentLengthValue = m_request.headers.value(HttpHeaders::ContentLength);
+    const QByteArrayView transferEncoding = m_request.headers.value(HttpHeaders::TransferEncoding);
+
+    // 分块编码优先于Content-Length
+    if (HttpHeaders::containsIgnoreCase(transferEncoding, "chunked")) {
+        m_state = State::ChunkSize;
+        return true;
+    }
+
+    // 没有请求体时同样经过Body状态，保证接收器总能收到finish()
+    if (contentLengthValue.isEmpty()) {
+        m_bodyRemaining = 0;
+        m_state = State::Body;
+        return true;
+    }
+
+    qint64 contentLength = 0;
+    if (!parseContentLength(contentLengthValue, contentLength)) {
+        fail(400, "Invalid Content-Length");
+        return false;
+    }
+    if (contentLength > m_limits.maxBodySize) {
+        fail(413, "Payload Too Large");
+        return false;
+    }
+
+    m_bodyRemaining = contentLength;
+    m_state = State::Body;
+    return true;
+}
+
+qint64 HttpRequestParser::consumeBody(qint64 maxBytes)
+{
+    qint64 available = m_buffer.size() - m_offset;
+    qint64 count = qMin(available, maxBytes);
+    if (count <= 0) {
+        return 0;
+    }
+
+    if (m_bodySink) {
+        if (!m_bodySink->write(m_buffer.constData() + m_offset, count)) {
+            if (m_bodySink->rejectStatus() != 0) {
+                fail(m_bodySink->rejectStatus(), m_bodySink->rejectMessage());
+            } else {
+                fail(500, "Failed to store request body");
+            }
+            return -1;
+        }
+    } else {
+        // 长度已知时预留空间，避免逐块扩容；预留量有上限，
+        // 声明了很大Content-Length却不发送数据的客户端不能借此占用内存
+        if (m_request.body.isEmpty() && m_state == State::Body) {
+            m_request.body.reserve(qMin(m_bodyRemaining, kMaxInitialBodyReserve));
+        }
+        m_request.body.append(m_buffer.constData() + m_offset, count);
+    }
+    m_offset += count;
+    m_bodyReceived += count;
+    return count;
+}
+
+qint64 HttpRequestParser::bodySizeLimit() const
+{
+    qint64 limit = m_bodySizeLimit >= 0 ? m_bodySizeLimit : m_limits.maxBodySize;
+    if (!m_bodySink) {
+        limit = qMin(limit, m_limits.maxInMemoryBodySize);
+    }
+    return limit;
+}
+
+bool HttpRequestParser::completeBody()
+{
+    if (m_bodySink && !m_bodySink->finish(m_request)) {
+        if (m_bodySink->rejectStatus() != 0) {
+            fail(m_bodySink->rejectStatus(), m_bodySink->rejectMessage());
+        } else {
+            fail(400, "Malformed request body");
+        }
+        return false;
+    }
+    m_state = State::Complete;
+    return true;
+}
+
+HttpRequestParser::Result HttpRequestParser::parse()
+{
+    while (true) {
+        switch (m_state) {
+        case State::RequestLine: {
+            QByteArrayView line;
+            if (!takeLine(line, m_limits.maxRequestLineSize)) {
+                return m_state == State::Error ? Result::Error : Result::NeedMoreData;
+            }
+            // 流水线请求之间允许出现空行
+            if (line.isEmpty()) {
+                break;
+            }
+            if (!parseRequestLine(line.toByteArray())) {
+                return Result::Error;
+            }
+            {
+                // 按已收到的头部字节数预留存储：头部已完整时恰好够用，否则为下限，之后按需增长
+                const qsizetype headerEnd = m_buffer.indexOf("\r\n\r\n", m_offset);
+                const qsizetype headerBytes = headerEnd < 0 ? m_buffer.size() - m_offset : headerEnd - m_offset;
+                m_request.headers.reserve(qMin<qsizetype>(headerBytes, m_limits.maxHeaderSize));
+            }
+            m_state = State::Headers;
+            break;
+        }
+        case State::Headers: {
+            QByteArrayView line;
+            if (!takeLine(line, m_limits.maxHeaderSize - m_headerBytes)) {
+                return m_state == State::Error ? Result::Error : Result::NeedMoreData;
+            }
+            m_headerBytes += static_cast<int>(line.size()) + 2;
+
+            // 空行标志头部结束
+            if (line.isEmpty()) {
+                if (!beginBody()) {
+                    return Result::Error;
+                }
+                // 头部完整后先交给调用方，由其决定请求体的去向
+                return Result::HeadersReady;
+            }
+            if (!parseHeaderLine(line)) {
+                return Result::Error;
+            }
+            break;
+        }
+        case State::Body: {
+            // 接收器在HeadersReady之后才确定，声明的长度在此按最终上限检查
+            if (m_bodyReceived == 0 && m_bodyRemaining > bodySizeLimit()) {
+                fail(413, "Payload Too Large");
+                return Result::Error;
+            }
+            qint64 consumed = consumeBody(m_bodyRemaining);
+            if (consumed < 0) {
+                return Result::Error;
+            }
+            m_bodyRemaining -= consumed;
+            if (m_bodyRemaining > 0) {
+                return Result::NeedMoreData;
+            }
+            if (!completeBody()) {
+                return Result::Error;
+            }
+            break;
+        }
+        case State::ChunkSize: {
+            QByteArrayView lineView;
+            if (!takeLine(lineView, m_limits.maxRequestLineSize)) {
+                return m_state == State::Error ? Result::Error : Result::NeedMoreData;
+            }
+            // 忽略块扩展（;之后的部分）
+            const qsizetype extension = lineView.indexOf(';');
+            if (extension >= 0) {
+                lineView.truncate(extension);
+            }
+            qint64 chunkSize = 0;
+            if (!parseChunkSize(trimmedView(lineView), chunkSize)) {
+                fail(400, "Invalid chunk size");
+                return Result::Error;
+            }
+            if (chunkSize == 0) {
+                m_state = State::ChunkTrailer;
+                break;
+            }
+            // 以差值比较，块大小接近qint64上限时也不会溢出
+            if (chunkSize > bodySizeLimit() - m_bodyReceived) {
+                fail(413, "Payload Too Large");
+                return Result::Error;
+            }
+            m_bodyRemaining = chunkSize;
+            m_state = State::ChunkData;
+            break;
+        }
+        case State::ChunkData: {
+            qint64 consumed = consumeBody(m_bodyRemaining);
+            if (consumed < 0) {
+                return Result::Error;
+            }
+            m_bodyRemaining -= consumed;
+            if (m_bodyRemaining > 0) {
+                return Result::NeedMoreData;
+            }
+            m_state = State::ChunkDataEnd;
+            break;
+        }
+        case State::ChunkDataEnd: {
+            QByteArrayView line;
+            if (!takeLine(line, 2)) {
+                return m_state == State::Error ? Result::Error : Result::NeedMoreData;
+            }
+            if (!line.isEmpty()) {
+                fail(400, "Malformed chunk");
+                return Result::Error;
+            }
+            m_state = State::ChunkSize;
+            break;
+        }
+        case State::ChunkTrailer: {
+            QByteArrayView line;
+            if (!takeLine(line, m_limits.maxHeaderSize)) {
+                return m_state == State::Error ? Result::Error : Result::NeedMoreData;
+            }
+            // trailer头部直接忽略，空行表示分块请求结束
+            if (line.isEmpty() && !completeBody()) {
+                return Result::Error;
+            }
+            break;
+        }
+        case State::Complete:
+            return Result::RequestReady;
+        case State::Error:
+            return Result::Error;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef HTTPREQUESTPARSER_H
+#define HTTPREQUESTPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+#include "Requesthandler.h"
+
+// 请求体接收器：设置后请求体数据直接交给接收器（例如写入临时文件），
+// 不再累积到HttpRequest::body中
+class HttpBodySink
+{
+public:
+    virtual ~HttpBodySink() {}
+
+    // 写入一段请求体数据，返回false表示写入失败
+    virtual bool write(const char* data, qint64 size) = 0;
+
+    // 请求体接收完毕，可在此把结果填入请求对象
+    virtual bool finish(RequestHandler::HttpRequest& request) = 0;
+
+    // 因内容不符合要求（而非存储失败）拒绝时的状态码和原因，0表示未拒绝
+    int rejectStatus() const { return m_rejectStatus; }
+    const QString& rejectMessage() const { return m_rejectMessage; }
+
+protected:
+    void reject(int status, const QString& message)
+    {
+        m_rejectStatus = status;
+        m_rejectMessage = message;
+    }
+
+private:
+    int m_rejectStatus = 0;
+    QString m_rejectMessage;
+};
+
+// 增量式HTTP请求解析器（状态机）
+// 每次readyRead把收到的字节追加进来，解析器在请求行、头部、请求体之间
+// 逐步推进，数据不足时返回NeedMoreData并在下一次调用时继续，不做任何阻塞等待
+class HttpRequestParser
+{
+public:
+    enum class State {
+        RequestLine,   // 等待请求行
+        Headers,       // 逐行读取头部
+        Body,          // 按Content-Length读取请求体
+        ChunkSize,     // 分块编码：读取块大小行
+        ChunkData,     // 分块编码：读取块数据
+        ChunkDataEnd,  // 分块编码：块数据后的CRLF
+        ChunkTrailer,  // 分块编码：结尾的trailer头部
+        Complete,      // 已得到完整请求
+        Error          // 请求格式错误，连接应当关闭
+    };
+
+    enum class Result {
+        NeedMoreData,
+        HeadersReady,  // 头部解析完毕，调用方可在读取请求体前设置接收器
+        RequestReady,
+        Error
+    };
+
+    struct Limits {
+        int maxRequestLineSize = 8 * 1024;
+        int maxHeaderSize = 64 * 1024;
+        // 请求体上限（写入接收器时，如上传的临时文件）
+        qint64 maxBodySize = 128LL * 1024 * 1024;
+        // 没有接收器、请求体累积在内存中时的上限，更大的请求体应由路由改为写入临时文件
+        qint64 maxInMemoryBodySize = 8 * 1024 * 1024;
+    };
+
+    HttpRequestParser();
+
+    void setLimits(const Limits& limits) { m_limits = limits; }
+
+    // 追加新收到的数据
+    void append(const QByteArray& data);
+
+    // 尽可能推进解析，返回RequestReady时可通过request()取得请求；
+    // 返回HeadersReady后再次调用parse()继续读取请求体
+    Result parse();
+
+    // 为当前请求设置请求体接收器（仅在HeadersReady之后、请求完成之前有效）
+    void setBodySink(std::unique_ptr<HttpBodySink> sink) { m_bodySink = std::move(sink); }
+
+    // 当前请求单独的请求体上限（仅在HeadersReady之后有效，reset()后恢复为Limits中的值），
+    // 分块编码的请求体在累计超过上限时立即失败
+    void setBodySizeLimit(qint64 maxBodySize) { m_bodySizeLimit = maxBodySize; }
+    // 当前请求体的上限：有接收器时为路由上限或maxBodySize，否则再受maxInMemoryBodySize限制
+    qint64 bodySizeLimit() const;
+
+    // Content-Length声明的请求体大小（HeadersReady之后有效），分块编码时返回-1
+    qint64 declaredBodySize() const { return m_state == State::Body ? m_bodyRemaining + m_bodyReceived : -1; }
+    // 当前请求已接收的请求体字节数（含写入临时文件的部分）
+    qint64 bodyBytesReceived() const { return m_bodyReceived; }
+
+    // 当前完整请求（仅在parse()返回RequestReady后有效）
+    const RequestHandler::HttpRequest& request() const { return m_request; }
+    RequestHandler::HttpRequest& request() { return m_request; }
+    const QString& httpVersion() const { return m_version; }
+
+    // 丢弃已完成的请求，准备解析缓冲区中的下一个（流水线）请求
+    void reset();
+
+    State state() const { return m_state; }
+    // 是否正在读取请求体（头部已解析、请求尚未完成）
+    bool readingBody() const
+    {
+        return m_state == State::Body || m_state == State::ChunkSize || m_state == State::ChunkData
+               || m_state == State::ChunkDataEnd || m_state == State::ChunkTrailer;
+    }
+    int errorStatus() const { return m_errorStatus; }
+    const QString& errorMessage() const { return m_errorMessage; }
+
+    // 缓冲区中是否还有未处理的数据
+    bool hasBufferedData() const { return m_offset < m_buffer.size(); }
+
+private:
+    Limits m_limits;
+    State m_state = State::RequestLine;
+
+    // 接收缓冲区及当前读取位置，已消费的数据在请求边界处统一丢弃
+    QByteArray m_buffer;
+    qsizetype m_offset = 0;
+
+    RequestHandler::HttpRequest m_request;
+    QString m_version;
+    int m_headerBytes = 0;
+    qint64 m_bodyRemaining = 0;
+    qint64 m_bodyReceived = 0;
+    // 小于0时使用m_limits.maxBodySize
+    qint64 m_bodySizeLimit = -1;
+    std::unique_ptr<HttpBodySink> m_bodySink;
+
+    int m_errorStatus = 0;
+    QString m_errorMessage;
+
+    // 从缓冲区取出一行（不含CRLF），不足一行返回false；
+    // line指向接收缓冲区，只在下一次append()之前有效
+    bool takeLine(QByteArrayView& line, int maxLength);
+
+    bool parseRequestLine(const QByteArray& line);
+    // 头部名称和值直接从接收缓冲区拷贝进请求的HttpHeaders，不经过QString
+    bool parseHeaderLine(QByteArrayView line);
+    // 头部结束后根据Content-Length / Transfer-Encoding决定请求体读取方式
+    bool beginBody();
+    // 读取请求体数据，返回已读取的字节数（写入接收器失败时返回-1）
+    qint64 consumeBody(qint64 maxBytes);
+    // 请求体读取完毕
+    bool completeBody();
+    void fail(int status, const QString& message);
+};
+
+#endif // HTTPREQUESTPARSER_H
@@ -0,0 +1,212 @@
+#include "HttpResponseWriter.h"
+#include <QDateTime>
+#include <QLocale>
+#include <charconv>
+
+namespace {
+// 所有响应共用的固定头部，只渲染一次
+const QByteArray kStaticHeaders =
+    "Server: QtHttpServer\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+    "Access-Control-Allow-Headers: Content-Type\r\n";
+
+struct StatusLine {
+    int code;
+    const char* reason;
+    QByteArray line;
+};
+
+const StatusLine kStatusLines[] = {
+    {200, "OK", "HTTP/1.1 200 OK\r\n"},
+    {201, "Created", "HTTP/1.1 201 Created\r\n"},
+    {204, "No Content", "HTTP/1.1 204 No Content\r\n"},
+    {206, "Partial Content", "HTTP/1.1 206 Partial Content\r\n"},
+    {304, "Not Modified", "HTTP/1.1 304 Not Modified\r\n"},
+    {400, "Bad Request", "HTTP/1.1 400 Bad Request\r\n"},
+    {404, "Not Found", "HTTP/1.1 404 Not Found\r\n"},
+    {413, "Payload Too Large", "HTTP/1.1 413 Payload Too Large\r\n"},
+    {415, "Unsupported Media Type", "HTTP/1.1 415 Unsupported Media Type\r\n"},
+    {416, "Range Not Satisfiable", "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {417, "Expectation Failed", "HTTP/1.1 417 Expectation Failed\r\n"},
+    {422, "Unprocessable Entity", "HTTP/1.1 422 Unprocessable Entity\r\n"},
+    {429, "Too Many Requests", "HTTP/1.1 429 Too Many Requests\r\n"},
+    {500, "Internal Server Error", "HTTP/1.1 500 Internal Server Error\r\n"},
+    {503, "Service Unavailable", "HTTP/1.1 503 Service Unavailable\r\n"},
+};
+
+struct ContentTypeLine {
+    const char* type;
+    QByteArray line;
+};
+
+const ContentTypeLine kContentTypes[] = {
+    {"application/json; charset=utf-8", "Content-Type: application/json; charset=utf-8\r\n"},
+    {"application/json", "Content-Type: application/json\r\n"},
+    {"text/plain", "Content-Type: text/plain\r\n"},
+};
+
+// 与固定头部重复的自定义头部不再输出
+bool isStaticHeader(const QString& name)
+{
+    return name.compare("Server", Qt::CaseInsensitive) == 0
+        || name.compare("Access-Control-Allow-Origin", Qt::CaseInsensitive) == 0
+        || name.compare("Access-Control-Allow-Methods", Qt::CaseInsensitive) == 0
+        || name.compare("Access-Control-Allow-Headers", Qt::CaseInsensitive) == 0;
+}
+}
+
+HttpResponseWriter::HttpResponseWriter()
+{
+    m_buffer.reserve(1024);
+}
+
+const QByteArray& HttpResponseWriter::dateHeader()
+{
+    struct DateCache {
+        qint64 second = -1;
+        QByteArray header;
+    };
+    thread_local DateCache cache;
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (now != cache.second) {
+        cache.second = now;
+        // RFC 7231 IMF-fixdate，例如: Sun, 06 Nov 1994 08:49:37 GMT
+        QDateTime utc = QDateTime::fromSecsSinceEpoch(now, Qt::UTC);
+        cache.header = "Date: "
+            + QLocale::c().toString(utc, "ddd, dd MMM yyyy hh:mm:ss").toLatin1()
+            + " GMT\r\n";
+    }
+    return cache.header;
+}
+
+void HttpResponseWriter::appendNumber(qint64 value)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr - digits);
+}
+
+void HttpResponseWriter::appendString(const QString& value)
+{
+    for (QChar ch : value) {
+        if (ch.unicode() >= 0x80) {
+            m_buffer.append(value.toUtf8());
+            return;
+        }
+    }
+    for (QChar ch : value) {
+        m_buffer.append(static_cast<char>(ch.unicode()));
+    }
+}
+
+void HttpResponseWriter::appendStatusLine(int statusCode, const QString& statusMessage)
+{
+    for (const StatusLine& status : kStatusLines) {
+        if (status.code == statusCode && statusMessage == QLatin1String(status.reason)) {
+            m_buffer.append(status.line);
+            return;
+        }
+    }
+
+    m_buffer.append("HTTP/1.1 ", 9);
+    appendNumber(statusCode);
+    m_buffer.append(' ');
+    appendString(statusMessage);
+    m_buffer.append("\r\n", 2);
+}
+
+void HttpResponseWriter::appendContentType(const QString& contentType)
+{
+    for (const ContentTypeLine& type : kContentTypes) {
+        if (contentType == QLatin1String(type.type)) {
+            m_buffer.append(type.line);
+            return;
+        }
+    }
+
+    m_buffer.append("Content-Type: ", 14);
+    appendString(contentType);
+    m_buffer.append("\r\n", 2);
+}
+
+QByteArray HttpResponseWriter::chunkHeader(qint64 size)
+{
+    QByteArray header = QByteArray::number(size, 16);
+    header.append("\r\n", 2);
+    return header;
+}
+
+const QByteArray& HttpResponseWriter::lastChunk()
+{
+    static const QByteArray chunk("0\r\n\r\n");
+    return chunk;
+}
+
+bool HttpResponseWriter::render(const RequestHandler::HttpResponse& response,
+                                int keepAliveTimeoutSecs, int keepAliveMax,
+                                BodyFraming framing)
+{
+    // resize(0)保留已分配的容量，缓冲区在连接的整个生命周期内复用
+    m_buffer.resize(0);
+
+    // 状态行
+    appendStatusLine(response.statusCode, response.statusMessage);
+
+    // 公共头部
+    m_buffer.append(dateHeader());
+    m_buffer.append(kStaticHeaders);
+    appendContentType(response.contentType);
+
+    if (framing == BodyFraming::Stream) {
+        // 没有长度，以连接关闭作为结束；事件流在流结束前一直保持连接
+        if (keepAliveMax >= 0) {
+            m_buffer.append("Connection: keep-alive\r\n", 24);
+        } else {
+            m_buffer.append("Connection: close\r\n", 19);
+        }
+    } else {
+        if (framing == BodyFraming::Chunked) {
+            m_buffer.append("Transfer-Encoding: chunked\r\n", 28);
+        } else if (response.statusCode != 204 && response.statusCode != 304) {
+            // 204/304没有响应体，不写Content-Length
+            // 文件响应体由连接单独发送，长度为文件区间长度
+            m_buffer.append("Content-Length: ", 16);
+            appendNumber(response.file ? response.fileLength : response.content.size());
+            m_buffer.append("\r\n", 2);
+        }
+
+        // 连接管理头部
+        if (keepAliveMax >= 0) {
+            m_buffer.append("Connection: keep-alive\r\nKeep-Alive: timeout=", 44);
+            appendNumber(keepAliveTimeoutSecs);
+            m_buffer.append(", max=", 6);
+            appendNumber(keepAliveMax);
+            m_buffer.append("\r\n", 2);
+        } else {
+            m_buffer.append("Connection: close\r\n", 19);
+        }
+    }
+
+    // 自定义头部
+    for (auto it = response.headers.constBegin(); it != response.headers.constEnd(); ++it) {
+        if (isStaticHeader(it.key())) {
+            continue;
+        }
+        appendString(it.key());
+        m_buffer.append(": ", 2);
+        appendString(it.value());
+        m_buffer.append("\r\n", 2);
+    }
+
+    // 空行标志头部结束
+    m_buffer.append("\r\n", 2);
+
+    // 小响应体与头部合并，一次写出
+    if (response.content.size() <= kInlineBodyLimit) {
+        m_buffer.append(response.content);
+        return true;
+    }
+    return false;
+}
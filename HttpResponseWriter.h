@@ -0,0 +1,52 @@
+#ifndef HTTPRESPONSEWRITER_H
+#define HTTPRESPONSEWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include "Requesthandler.h"
+
+// HTTP响应序列化
+// 状态行和头部直接渲染到一个可复用的字节缓冲区：Date头部按秒缓存，
+// Server/CORS等固定头部预先渲染，常见状态行和Content-Type查表得到，
+// 小响应体直接追加到同一缓冲区，整个响应只需一次socket写入
+class HttpResponseWriter
+{
+public:
+    // 不超过此大小的响应体与头部合并写出
+    static const int kInlineBodyLimit = 64 * 1024;
+
+    // 响应体的分帧方式
+    enum class BodyFraming {
+        ContentLength,  // 普通响应，写Content-Length
+        Chunked,        // 流式响应体，Transfer-Encoding: chunked，以零长度块结束
+        Stream          // 长度未知，持续写入直到连接关闭（事件流、HTTP/1.0客户端的流式响应体）
+    };
+
+    HttpResponseWriter();
+
+    // 渲染响应头（及可内联的响应体）。keepAliveMax<0时写Connection: close。
+    // 返回值表示响应体是否已包含在buffer()中
+    bool render(const RequestHandler::HttpResponse& response, int keepAliveTimeoutSecs, int keepAliveMax,
+                BodyFraming framing = BodyFraming::ContentLength);
+
+    const QByteArray& buffer() const { return m_buffer; }
+
+    // chunked编码的块头（十六进制长度+CRLF），块数据后需再写CRLF
+    static QByteArray chunkHeader(qint64 size);
+    // chunked编码的结束块
+    static const QByteArray& lastChunk();
+
+    // 当前线程缓存的Date头部（含结尾CRLF），每秒只格式化一次
+    static const QByteArray& dateHeader();
+
+private:
+    QByteArray m_buffer;
+
+    void appendNumber(qint64 value);
+    // ASCII内容逐字符追加，避免中间QByteArray
+    void appendString(const QString& value);
+    void appendStatusLine(int statusCode, const QString& statusMessage);
+    void appendContentType(const QString& contentType);
+};
+
+#endif // HTTPRESPONSEWRITER_H
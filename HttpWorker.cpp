@@ -0,0 +1,134 @@
+#include "HttpWorker.h"
+#include <QThread>
+#include <QDebug>
+#include <QElapsedTimer>
+#include "Metrics.h"
+
+#if HAS_SSL
+#include <QSslSocket>
+
+namespace {
+struct TlsMetrics {
+    MetricHistogram* handshake;
+    MetricCounter* failures;
+};
+
+const TlsMetrics& tlsMetrics()
+{
+    static const TlsMetrics metrics = [] {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        return TlsMetrics{
+            registry.histogram("tls_handshake_duration_seconds", "Server-side TLS handshake time"),
+            registry.counter("tls_handshake_failures_total", "Connections closed before the TLS handshake completed"),
+        };
+    }();
+    return metrics;
+}
+}
+#endif
+
+HttpWorker::HttpWorker(RequestHandler* requestHandler, HttpAdmissionController* admission,
+                       const HttpConnectionSettings& settings, bool useSsl, QObject* parent)
+    : QObject(parent),
+      m_requestHandler(requestHandler),
+      m_admission(admission),
+      m_settings(settings),
+      m_useSsl(useSsl)
+{
+}
+
+bool HttpWorker::admitClient(QTcpSocket* socket, bool plainHttp)
+{
+    QString clientAddress = socket->peerAddress().toString();
+    if (m_admission->tryAdmitClient(clientAddress)) {
+        return true;
+    }
+
+    qWarning() << "客户端连接数超过上限，拒绝连接:" << clientAddress;
+    m_admission->releaseConnection(QString());
+    m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+    HttpAdmissionController::rejectSocket(socket, plainHttp);
+    return false;
+}
+
+void HttpWorker::startConnection(QTcpSocket* socket)
+{
+    HttpConnection* connection = new HttpConnection(socket, m_requestHandler, m_admission, m_settings, this);
+
+    // 对端地址在断开后不可再取，提前保存用于归还名额
+    QString clientAddress = socket->peerAddress().toString();
+    connect(connection, &HttpConnection::closed, this, [this, clientAddress](HttpConnection*) {
+        m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+        m_admission->releaseConnection(clientAddress);
+    });
+}
+
+void HttpWorker::addConnection(qintptr socketDescriptor)
+{
+#if HAS_SSL
+    if (m_useSsl) {
+        // 使用SSL Socket
+        QSslSocket* sslSocket = new QSslSocket(this);
+
+        if (sslSocket->setSocketDescriptor(socketDescriptor)) {
+            // 握手之前无法回复HTTP错误，超限时直接断开
+            if (!admitClient(sslSocket, false)) {
+                return;
+            }
+
+            // 预先构建的配置直接应用到套接字，不再每次从全局默认配置复制和解析
+            sslSocket->setSslConfiguration(m_sslConfiguration);
+
+            QElapsedTimer handshakeTimer;
+            handshakeTimer.start();
+            connect(sslSocket, &QSslSocket::encrypted, this, [sslSocket, handshakeTimer]() {
+                tlsMetrics().handshake->observeNanoseconds(handshakeTimer.nsecsElapsed());
+                qDebug() << "SSL连接已建立，客户端:" << sslSocket->peerAddress().toString()
+                         << "协议:" << sslSocket->sessionProtocol()
+                         << "耗时(ms):" << handshakeTimer.elapsed();
+            });
+            connect(sslSocket, &QAbstractSocket::errorOccurred, this, [sslSocket](QAbstractSocket::SocketError) {
+                if (!sslSocket->isEncrypted()) {
+                    tlsMetrics().failures->inc();
+                    qWarning() << "SSL握手失败:" << sslSocket->errorString();
+                }
+            });
+
+            // 读取和断开由连接对象处理，同一TLS会话上可复用多个请求
+            startConnection(sslSocket);
+
+            // 启动服务器端加密
+            sslSocket->startServerEncryption();
+        } else {
+            qWarning() << "无法为SSL套接字设置套接字描述符";
+            m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+            m_admission->releaseConnection(QString());
+            sslSocket->deleteLater();
+        }
+        return;
+    }
+#endif
+
+    // 使用标准TCP Socket（当没有SSL或SSL未启用时）
+    QTcpSocket* client = new QTcpSocket(this);
+    if (!client->setSocketDescriptor(socketDescriptor)) {
+        qWarning() << "无法为套接字设置套接字描述符";
+        m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
+        m_admission->releaseConnection(QString());
+        client->deleteLater();
+        return;
+    }
+
+    if (!admitClient(client, true)) {
+        return;
+    }
+
+    // 增加这两行设置超时时间和保持连接
+    client->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    qDebug() << "新的HTTP连接来自:" << client->peerAddress().toString() << ":" << client->peerPort()
+             << "工作线程:" << QThread::currentThreadId();
+
+    startConnection(client);
+}
@@ -0,0 +1,53 @@
+#ifndef HTTPWORKER_H
+#define HTTPWORKER_H
+
+#include <QObject>
+#include <atomic>
+#include "HttpConnection.h"
+#include "HttpAdmissionController.h"
+
+#if HAS_SSL
+#include <QSslConfiguration>
+#endif
+
+// HTTP工作线程上的连接管理者
+// 每个HttpWorker运行在独立线程的事件循环中，套接字和HttpConnection都在该线程创建，
+// 读写与请求处理不再占用GUI线程
+class HttpWorker : public QObject
+{
+    Q_OBJECT
+public:
+    HttpWorker(RequestHandler* requestHandler, HttpAdmissionController* admission,
+               const HttpConnectionSettings& settings, bool useSsl, QObject* parent = nullptr);
+
+    // 当前负责的连接数（包括已分配但尚未建立的），用于最少连接调度
+    int connectionCount() const { return m_connectionCount.load(std::memory_order_relaxed); }
+
+    // 由HttpServer在分配连接时调用（任意线程）
+    void reserveConnection() { m_connectionCount.fetch_add(1, std::memory_order_relaxed); }
+
+#if HAS_SSL
+    // 新SSL连接使用的配置，需在工作线程开始接受连接之前设置
+    void setSslConfiguration(const QSslConfiguration& configuration) { m_sslConfiguration = configuration; }
+#endif
+
+public slots:
+    // 在本工作线程中接管套接字描述符
+    void addConnection(qintptr socketDescriptor);
+
+private:
+    RequestHandler* m_requestHandler;
+    HttpAdmissionController* m_admission;
+    HttpConnectionSettings m_settings;
+    bool m_useSsl;
+#if HAS_SSL
+    QSslConfiguration m_sslConfiguration;
+#endif
+    std::atomic<int> m_connectionCount{0};
+
+    // 按客户端连接数上限准入，失败时回复503并关闭套接字
+    bool admitClient(QTcpSocket* socket, bool plainHttp);
+    void startConnection(QTcpSocket* socket);
+};
+
+#endif // HTTPWORKER_H
@@ -6,6 +6,12 @@
 #include <QNetworkInterface>
 #include "Requesthandler.h"
 #include "Databaseworker.h"
+#include "HttpConnection.h"
+#include "HttpWorker.h"
+#include "HttpAdmissionController.h"
+#include "ControlChannelServer.h"
+#include <QThread>
+#include <QVector>
 #include "NavigationDisplayWidget.h"
 
 // 检查是否有Qt SSL支持
@@ -20,6 +26,7 @@ class HttpServer : public QTcpServer
     Q_OBJECT
 public:
     explicit HttpServer(DatabaseWorker* dbWorker, QObject* parent = nullptr);
+    ~HttpServer();
     
     // 注册导航显示部件以接收导航数据
     void registerNavigationWidget(NavigationDisplayWidget* widget);
@@ -28,39 +35,81 @@ public:
     QString getLocalIpAddress() const;
     RequestHandler& getRequestHandler() { return m_requestHandler; }
 
-     // 直接连接导航信号
+     // 让显示部件直接订阅进程内的导航状态（不再经本机HTTP轮询）
      void connectNavigationSignals(NavigationDisplayWidget* widget) {
         if (widget) {
-            connect(&m_requestHandler, &RequestHandler::navigationDataReceived,
-                   widget, &NavigationDisplayWidget::updateNavigation,
-                   Qt::QueuedConnection);
+            widget->setNavigationStore(&m_requestHandler.navigationState());
             qDebug() << "导航信号已连接";
         }
     }
 #if HAS_SSL
     // 仅在有SSL支持时编译此函数
-    bool setupSslConfiguration();
+    // 加载证书和私钥（支持ECDSA和RSA），构建本服务器专用的TLS配置并直接应用到每个套接字，
+    // 不再修改全局默认配置；需在listen()之前调用
+    bool setupSslConfiguration(const QString& certPath = "server.crt", const QString& keyPath = "server.key");
+    const QSslConfiguration& sslConfiguration() const { return m_sslConfiguration; }
 #endif
 
+    // 持久连接设置：空闲超时（毫秒）和单连接最大请求数
+    void setKeepAliveTimeout(int msecs) { m_connectionSettings.keepAliveTimeoutMs = msecs; }
+    void setMaxRequestsPerConnection(int count) { m_connectionSettings.maxRequestsPerConnection = count; }
+
+    // 响应压缩设置：最小压缩大小（字节）和zlib压缩级别（1-9）
+    void setCompressionEnabled(bool enabled) { m_connectionSettings.compression.enabled = enabled; }
+    void setCompressionThreshold(int bytes) { m_connectionSettings.compression.minSize = qMax(0, bytes); }
+    void setCompressionLevel(int level) { m_connectionSettings.compression.level = qBound(1, level, 9); }
+
+    // 连接处理线程数，需在listen()之前设置；0表示在主线程处理（旧行为）
+    void setWorkerThreadCount(int count) { m_workerThreadCount = qMax(0, count); }
+    int workerThreadCount() const { return m_workerThreadCount; }
+
+    // 当前活动连接数
+    int activeConnectionCount() const;
+
+    // 准入控制：连接数上限，以及按路由类别的限速和并发上限
+    void setMaxConnections(int count) { m_admission.setMaxConnections(count); }
+    void setMaxConnectionsPerClient(int count) { m_admission.setMaxConnectionsPerClient(count); }
+    HttpAdmissionController& admissionController() { return m_admission; }
+
+    // 在独立线程上启动WebSocket控制通道（页面切换、PDF翻页），启用SSL时使用wss；
+    // 需在setupSslConfiguration()之后调用
+    bool startControlChannel(quint16 port);
+
 protected:
     void incomingConnection(qintptr socketDescriptor) override;
 
-private slots:
-    void readClient();
-    void discardClient();
-
 private:
     RequestHandler m_requestHandler;
     QMutex m_requestMutex;
-    QString findHeaderIgnoreCase(const QMap<QString, QString>& headers, const QString& name) const;
     // 是否使用SSL
     bool m_useSsl = false;
-    
-    // 发送HTTP响应 - 使用基类QTcpSocket
-    void sendResponse(QTcpSocket* socket, const RequestHandler::HttpResponse& response);
-    
-    // 发送错误响应 - 使用基类QTcpSocket
-    void sendErrorResponse(QTcpSocket* socket, int statusCode, const QString& message);
+#if HAS_SSL
+    // 预先构建的服务器TLS配置，所有连接共用
+    QSslConfiguration m_sslConfiguration;
+#endif
+
+    // 新连接使用的设置
+    HttpConnectionSettings m_connectionSettings;
+    // 所有工作线程共享的准入控制
+    HttpAdmissionController m_admission;
+
+    // 连接处理线程及其上的工作对象
+    int m_workerThreadCount = 2;
+    QVector<QThread*> m_workerThreads;
+    QVector<HttpWorker*> m_workers;
+    int m_nextWorker = 0;
+
+    // 控制通道及其线程，不受界面线程繁忙影响
+    QThread* m_controlThread = nullptr;
+    ControlChannelServer* m_controlChannel = nullptr;
+    void stopControlChannel();
+
+    // 首个连接到达时按当前配置创建工作线程
+    void startWorkers();
+    void stopWorkers();
+
+    // 选择连接数最少的工作对象，相同时轮询
+    HttpWorker* pickWorker();
 };
 
 #endif // HTTPSERVER_H
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef LATESTVALUEMAILBOX_H
+#define LATESTVALUEMAILBOX_H
+
+#include <QObject>
+#include <QMetaObject>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 最新值邮箱：任意线程以任意频率post()，值放入单一槽位（原子替换，旧值直接丢弃），
+// 接收对象所在线程的事件循环每轮最多处理一次，且只处理最新的值。
+// 用于高频的界面更新（摄像头帧、性能指标、导航显示）：界面线程落后时
+// 事件队列里最多只有一个待处理的投递，不会积压并依次重放过时的状态
+template <typename T>
+class LatestValueMailbox
+{
+public:
+    // handler在receiver所在线程调用；邮箱应是receiver的成员，随其一起销毁
+    LatestValueMailbox(QObject* receiver, std::function<void(const T&)> handler)
+        : m_receiver(receiver),
+          m_handler(std::move(handler))
+    {
+    }
+
+    ~LatestValueMailbox()
+    {
+        delete m_slot.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    LatestValueMailbox(const LatestValueMailbox&) = delete;
+    LatestValueMailbox& operator=(const LatestValueMailbox&) = delete;
+
+    void post(T value)
+    {
+        m_posted.fetch_add(1, std::memory_order_relaxed);
+        delete m_slot.exchange(new T(std::move(value)), std::memory_order_acq_rel);
+
+        // 已有待处理的投递时只替换值，不再排队
+        if (!m_scheduled.exchange(true, std::memory_order_acq_rel)) {
+            QMetaObject::invokeMethod(m_receiver, [this]() { deliver(); }, Qt::QueuedConnection);
+        }
+    }
+
+    // 已投递和实际处理的次数，差值即被合并掉的过时值
+    quint64 postedCount() const { return m_posted.load(std::memory_order_relaxed); }
+    quint64 deliveredCount() const { return m_delivered.load(std::memory_order_relaxed); }
+
+private:
+    void deliver()
+    {
+        // 先清除标志再取值：取值之后到达的新值会重新排队，不会丢失
+        m_scheduled.store(false, std::memory_order_release);
+        std::unique_ptr<T> value(m_slot.exchange(nullptr, std::memory_order_acq_rel));
+        if (!value) {
+            return;
+        }
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+        m_handler(*value);
+    }
+
+    QObject* m_receiver;
+    std::function<void(const T&)> m_handler;
+    std::atomic<T*> m_slot{nullptr};
+    std::atomic<bool> m_scheduled{false};
+    std::atomic<quint64> m_posted{0};
+    std::atomic<quint64> m_delivered{0};
+};
+
+#endif // LATESTVALUEMAILBOX_H
@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QTime>
 #include <QPainter>
+#include <QJsonObject>
 #include "Httpserver.h"
 #include "NavigationDisplayWidget.h"
 #include "VisionPage.h"
@@ -94,10 +95,22 @@ void MainWindow::setHttpServer(HttpServer* server)
             // 只连接通用信号
             if (m_httpServer) {
                 RequestHandler& handler = m_httpServer->getRequestHandler();
+                // 信号在HTTP工作线程上发出，显式排队到GUI线程
                 connect(&handler, &RequestHandler::switchPageRequested, 
-                        this, &MainWindow::handleSwitchPage);
+                        this, &MainWindow::handleSwitchPage, Qt::QueuedConnection);
                 connect(&handler, &RequestHandler::backToMainRequested, 
-                        this, &MainWindow::handleBackToMain);
+                        this, &MainWindow::handleBackToMain, Qt::QueuedConnection);
+
+                // 控制通道确认命令时上报的界面状态（在GUI线程调用）
+                handler.setUiStateProvider([this]() {
+                    QJsonObject state;
+                    state["pageIndex"] = stackedWidget->currentIndex();
+                    if (pdfViewerPage) {
+                        state["pdfPage"] = pdfViewerPage->currentPageNumber();
+                        state["pdfPageCount"] = pdfViewerPage->pageCount();
+                    }
+                    return state;
+                });
                 
                 // 注意: 特定页面的信号连接会在页面初始化时完成
                 qDebug() << "HTTP服务器基本信号已连接";
@@ -244,6 +257,13 @@ void MainWindow::initPageIfNeeded(int iconIndex, int targetIndex)
                 updateIndicator();
                 PageChangeEvent(0);
             });
+
+            // 本地保存的翻译记录使HTTP接口的缓存版本失效
+            if (m_httpServer) {
+                RequestHandler& handler = m_httpServer->getRequestHandler();
+                connect(translatePage, &TranslatePage::translationSaved,
+                        &handler, &RequestHandler::invalidateDataVersion, Qt::DirectConnection);
+            }
             break;
         }
         case 1: // PDF查看器页面
@@ -261,12 +281,12 @@ void MainWindow::initPageIfNeeded(int iconIndex, int targetIndex)
             // 连接HTTP服务器信号(如果已设置)
             if (m_httpServer) {
                 RequestHandler& handler = m_httpServer->getRequestHandler();
-                connect(&handler, &RequestHandler::pdfDataReceived, 
-                        pdfViewerPage, &PDFViewerPage::networkLoadPDF);
+                connect(&handler, &RequestHandler::pdfDocumentReceived, 
+                        pdfViewerPage, &PDFViewerPage::networkLoadPDF, Qt::QueuedConnection);
                 connect(&handler, &RequestHandler::pdfNextPage, 
-                        pdfViewerPage, &PDFViewerPage::nextPage);
+                        pdfViewerPage, &PDFViewerPage::nextPage, Qt::QueuedConnection);
                 connect(&handler, &RequestHandler::pdfPrevPage, 
-                        pdfViewerPage, &PDFViewerPage::prevPage);
+                        pdfViewerPage, &PDFViewerPage::prevPage, Qt::QueuedConnection);
             }
             break;
         }
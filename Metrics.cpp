@@ -0,0 +1,217 @@
+#include "Metrics.h"
+#include <QMutexLocker>
+
+void MetricGauge::add(double delta)
+{
+    double current = m_value.load(std::memory_order_relaxed);
+    while (!m_value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+MetricHistogram::MetricHistogram(std::vector<double> bounds)
+    : m_bounds(std::move(bounds)),
+      m_buckets(new std::atomic<quint64>[m_bounds.size() + 1])
+{
+    for (size_t i = 0; i <= m_bounds.size(); ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::observe(double seconds)
+{
+    // 桶数量很少，线性查找比二分更快
+    size_t index = 0;
+    while (index < m_bounds.size() && seconds > m_bounds[index]) {
+        ++index;
+    }
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(static_cast<quint64>(qMax(0.0, seconds) * 1e9), std::memory_order_relaxed);
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::vector<double> MetricsRegistry::defaultLatencyBuckets()
+{
+    return {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+}
+
+QByteArray MetricsRegistry::label(const char* key, const QString& value)
+{
+    QByteArray escaped;
+    const QByteArray utf8 = value.toUtf8();
+    escaped.reserve(utf8.size());
+    for (char ch : utf8) {
+        if (ch == '\\' || ch == '"') {
+            escaped.append('\\').append(ch);
+        } else if (ch == '\n') {
+            escaped.append("\\n");
+        } else {
+            escaped.append(ch);
+        }
+    }
+    return QByteArray(key) + "=\"" + escaped + "\"";
+}
+
+MetricsRegistry::Series* MetricsRegistry::findOrCreate(const QByteArray& name, const QByteArray& help,
+                                                       Type type, const QByteArray& labels)
+{
+    Family* family = nullptr;
+    for (const auto& existing : m_families) {
+        if (existing->name == name) {
+            family = existing.get();
+            break;
+        }
+    }
+    if (!family) {
+        m_families.push_back(std::make_unique<Family>());
+        family = m_families.back().get();
+        family->name = name;
+        family->help = help;
+        family->type = type;
+    }
+
+    for (const auto& series : family->series) {
+        if (series->labels == labels) {
+            return series.get();
+        }
+    }
+    family->series.push_back(std::make_unique<Series>());
+    family->series.back()->labels = labels;
+    return family->series.back().get();
+}
+
+MetricCounter* MetricsRegistry::counter(const QByteArray& name, const QByteArray& help, const QByteArray& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* series = findOrCreate(name, help, Type::Counter, labels);
+    if (!series->counter) {
+        series->counter = std::make_unique<MetricCounter>();
+    }
+    return series->counter.get();
+}
+
+MetricGauge* MetricsRegistry::gauge(const QByteArray& name, const QByteArray& help, const QByteArray& labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* series = findOrCreate(name, help, Type::Gauge, labels);
+    if (!series->gauge) {
+        series->gauge = std::make_unique<MetricGauge>();
+    }
+    return series->gauge.get();
+}
+
+MetricHistogram* MetricsRegistry::histogram(const QByteArray& name, const QByteArray& help,
+                                            const QByteArray& labels, std::vector<double> bounds)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* series = findOrCreate(name, help, Type::Histogram, labels);
+    if (!series->histogram) {
+        series->histogram = std::make_unique<MetricHistogram>(std::move(bounds));
+    }
+    return series->histogram.get();
+}
+
+MetricCallbackHandle::MetricCallbackHandle(MetricCallbackHandle&& other) noexcept
+    : m_id(other.m_id)
+{
+    other.m_id = 0;
+}
+
+MetricCallbackHandle& MetricCallbackHandle::operator=(MetricCallbackHandle&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_id = other.m_id;
+        other.m_id = 0;
+    }
+    return *this;
+}
+
+void MetricCallbackHandle::reset()
+{
+    if (m_id != 0) {
+        MetricsRegistry::instance().removeCallback(m_id);
+        m_id = 0;
+    }
+}
+
+MetricCallbackHandle MetricsRegistry::gaugeCallback(const QByteArray& name, const QByteArray& help,
+                                                    const QByteArray& labels, std::function<double()> callback)
+{
+    QMutexLocker locker(&m_mutex);
+    Series* series = findOrCreate(name, help, Type::Gauge, labels);
+    series->callback = std::move(callback);
+    series->callbackId = m_nextCallbackId++;
+    return MetricCallbackHandle(series->callbackId);
+}
+
+void MetricsRegistry::removeCallback(quint64 id)
+{
+    // 与render共用锁：返回后导出线程不会再调用该回调
+    QMutexLocker locker(&m_mutex);
+    for (const auto& family : m_families) {
+        for (const auto& series : family->series) {
+            if (series->callbackId == id) {
+                series->callback = nullptr;
+                series->callbackId = 0;
+                return;
+            }
+        }
+    }
+}
+
+QByteArray MetricsRegistry::render() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray out;
+    out.reserve(16 * 1024);
+
+    auto appendSample = [&out](const QByteArray& name, const QByteArray& labels, const QByteArray& value) {
+        out.append(name);
+        if (!labels.isEmpty()) {
+            out.append('{').append(labels).append('}');
+        }
+        out.append(' ').append(value).append('\n');
+    };
+    auto joinLabels = [](const QByteArray& labels, const QByteArray& extra) {
+        return labels.isEmpty() ? extra : labels + ',' + extra;
+    };
+
+    for (const auto& family : m_families) {
+        const char* typeName = family->type == Type::Counter ? "counter"
+                             : family->type == Type::Gauge ? "gauge" : "histogram";
+        out.append("# HELP ").append(family->name).append(' ').append(family->help).append('\n');
+        out.append("# TYPE ").append(family->name).append(' ').append(typeName).append('\n');
+
+        for (const auto& series : family->series) {
+            if (series->counter) {
+                appendSample(family->name, series->labels, QByteArray::number(series->counter->value()));
+            } else if (series->callback) {
+                appendSample(family->name, series->labels, QByteArray::number(series->callback(), 'g', 10));
+            } else if (series->gauge) {
+                appendSample(family->name, series->labels, QByteArray::number(series->gauge->value(), 'g', 10));
+            } else if (series->histogram) {
+                const MetricHistogram& histogram = *series->histogram;
+                const QByteArray bucketName = family->name + "_bucket";
+                quint64 cumulative = 0;
+                for (size_t i = 0; i < histogram.bounds().size(); ++i) {
+                    cumulative += histogram.bucketCount(i);
+                    appendSample(bucketName,
+                                 joinLabels(series->labels, "le=\"" + QByteArray::number(histogram.bounds()[i], 'g', 6) + "\""),
+                                 QByteArray::number(cumulative));
+                }
+                cumulative += histogram.bucketCount(histogram.bounds().size());
+                appendSample(bucketName, joinLabels(series->labels, "le=\"+Inf\""), QByteArray::number(cumulative));
+                appendSample(family->name + "_sum", series->labels, QByteArray::number(histogram.sum(), 'g', 10));
+                appendSample(family->name + "_count", series->labels, QByteArray::number(cumulative));
+            }
+        }
+    }
+    return out;
+}
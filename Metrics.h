@@ -0,0 +1,137 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// 运行指标（Prometheus文本格式导出，见 /metrics）
+// 指标对象在注册时创建、此后地址不变；热路径上只做原子操作，不加锁
+
+// 单调递增计数器
+class MetricCounter
+{
+public:
+    void inc(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// 可增可减的瞬时值
+class MetricGauge
+{
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(double delta);
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+// 固定分桶的直方图，桶上界单位为秒
+class MetricHistogram
+{
+public:
+    explicit MetricHistogram(std::vector<double> bounds);
+
+    void observe(double seconds);
+    void observeNanoseconds(qint64 nanoseconds) { observe(nanoseconds / 1e9); }
+
+    const std::vector<double>& bounds() const { return m_bounds; }
+    // 第index个桶（非累计）的计数，index==bounds().size()为+Inf桶
+    quint64 bucketCount(size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    double sum() const { return m_sumNs.load(std::memory_order_relaxed) / 1e9; }
+
+private:
+    std::vector<double> m_bounds;
+    std::unique_ptr<std::atomic<quint64>[]> m_buckets;
+    std::atomic<quint64> m_count{0};
+    // 以纳秒整数累加，避免浮点原子加
+    std::atomic<quint64> m_sumNs{0};
+};
+
+// gaugeCallback的注册凭据：析构（或reset）时撤销回调，之后导出不会再调用它。
+// 回调捕获的对象应持有凭据，并在自身销毁之前释放
+class MetricCallbackHandle
+{
+public:
+    MetricCallbackHandle() = default;
+    MetricCallbackHandle(MetricCallbackHandle&& other) noexcept;
+    MetricCallbackHandle& operator=(MetricCallbackHandle&& other) noexcept;
+    MetricCallbackHandle(const MetricCallbackHandle&) = delete;
+    MetricCallbackHandle& operator=(const MetricCallbackHandle&) = delete;
+    ~MetricCallbackHandle() { reset(); }
+
+    void reset();
+
+private:
+    friend class MetricsRegistry;
+    explicit MetricCallbackHandle(quint64 id) : m_id(id) {}
+    quint64 m_id = 0;
+};
+
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& instance();
+
+    // 请求延迟默认分桶：0.5ms ~ 10s
+    static std::vector<double> defaultLatencyBuckets();
+
+    // 注册或取回指标；labels为已格式化的标签，如 method="GET",route="/api/data"。
+    // 同名同标签重复注册返回同一对象
+    MetricCounter* counter(const QByteArray& name, const QByteArray& help, const QByteArray& labels = QByteArray());
+    MetricGauge* gauge(const QByteArray& name, const QByteArray& help, const QByteArray& labels = QByteArray());
+    MetricHistogram* histogram(const QByteArray& name, const QByteArray& help, const QByteArray& labels = QByteArray(),
+                               std::vector<double> bounds = defaultLatencyBuckets());
+    // 导出时才求值的指标（如线程池状态），回调在导出线程调用；
+    // 返回的凭据释放后回调即被撤销，撤销返回时不会有正在执行的回调
+    [[nodiscard]] MetricCallbackHandle gaugeCallback(const QByteArray& name, const QByteArray& help,
+                                                     const QByteArray& labels, std::function<double()> callback);
+
+    // 生成 text/plain; version=0.0.4 格式的导出内容
+    QByteArray render() const;
+
+    // 生成单个标签 key="value"，对值做转义
+    static QByteArray label(const char* key, const QString& value);
+
+private:
+    friend class MetricCallbackHandle;
+    MetricsRegistry() = default;
+
+    void removeCallback(quint64 id);
+
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        QByteArray labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+        std::function<double()> callback;
+        quint64 callbackId = 0;
+    };
+
+    struct Family {
+        QByteArray name;
+        QByteArray help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    mutable QMutex m_mutex;
+    std::vector<std::unique_ptr<Family>> m_families;
+    quint64 m_nextCallbackId = 1;
+
+    Series* findOrCreate(const QByteArray& name, const QByteArray& help, Type type, const QByteArray& labels);
+};
+
+#endif // METRICS_H
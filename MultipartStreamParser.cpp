@@ -0,0 +1,255 @@
+#include "MultipartStreamParser.h"
+#include <QDir>
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace {
+// 分段头部的最大长度，超过视为格式错误
+const int kMaxPartHeaderSize = 16 * 1024;
+
+std::shared_ptr<QTemporaryFile> createUploadFile()
+{
+    auto file = std::make_shared<QTemporaryFile>(QDir::tempPath() + "/ar_upload_XXXXXX.pdf");
+    if (!file->open()) {
+        qWarning() << "无法创建上传临时文件:" << file->errorString();
+        return nullptr;
+    }
+    return file;
+}
+}
+
+bool MagicPrefixCheck::feed(const char* data, qint64 size)
+{
+    while (m_matched < m_prefix.size() && size > 0) {
+        if (*data != m_prefix.at(m_matched)) {
+            return false;
+        }
+        ++m_matched;
+        ++data;
+        --size;
+    }
+    return true;
+}
+
+TempFileBodySink::TempFileBodySink()
+{
+}
+
+bool TempFileBodySink::write(const char* data, qint64 size)
+{
+    if (!m_magic.feed(data, size)) {
+        qWarning() << "上传内容的文件头不符合要求，拒绝";
+        reject(415, "Unsupported Media Type");
+        return false;
+    }
+    m_size += size;
+
+    if (!m_opened) {
+        m_opened = true;
+        m_file = createUploadFile();
+    }
+    return m_file && m_file->write(data, size) == size;
+}
+
+bool TempFileBodySink::finish(RequestHandler::HttpRequest& request)
+{
+    if (!m_magic.complete(m_size)) {
+        reject(415, "Unsupported Media Type");
+        return false;
+    }
+    if (m_file) {
+        m_file->flush();
+        qDebug() << "上传数据已写入临时文件:" << m_file->fileName() << "大小:" << m_file->size() << "字节";
+    }
+    request.uploadedFile = m_file;
+    return true;
+}
+
+MultipartStreamParser::MultipartStreamParser(const QByteArray& boundary, const QStringList& fileFieldNames)
+    : m_delimiter("\r\n--" + boundary),
+      m_fileFieldNames(fileFieldNames)
+{
+    // 在数据前补一个CRLF，使第一个边界与后续边界格式一致
+    m_pending = "\r\n";
+}
+
+QByteArray MultipartStreamParser::boundaryFromContentType(const QString& contentType)
+{
+    int boundaryPos = contentType.indexOf("boundary=");
+    if (boundaryPos <= 0) {
+        return QByteArray();
+    }
+
+    QString boundary = contentType.mid(boundaryPos + 9);
+    int end = boundary.indexOf(';');
+    if (end >= 0) {
+        boundary.truncate(end);
+    }
+    boundary = boundary.trimmed();
+    if (boundary.startsWith("\"") && boundary.endsWith("\"")) {
+        boundary = boundary.mid(1, boundary.length() - 2);
+    }
+    return boundary.toUtf8();
+}
+
+bool MultipartStreamParser::write(const char* data, qint64 size)
+{
+    if (m_state == State::Error) {
+        return false;
+    }
+    if (m_state == State::Done) {
+        // 结束边界之后的尾声数据直接丢弃
+        return true;
+    }
+
+    m_pending.append(data, size);
+    return processPending();
+}
+
+bool MultipartStreamParser::writePartData(const char* data, qint64 size)
+{
+    if (!m_inFilePart || size <= 0) {
+        return true;
+    }
+    if (!m_magic.feed(data, size)) {
+        qWarning() << "上传文件的文件头不符合要求，拒绝";
+        reject(415, "Unsupported Media Type");
+        return false;
+    }
+    if (m_file->write(data, size) != size) {
+        qWarning() << "写入上传临时文件失败:" << m_file->errorString();
+        return false;
+    }
+    m_fileSize += size;
+    return true;
+}
+
+bool MultipartStreamParser::startPart(const QByteArray& partHeaders)
+{
+    static const QRegularExpression nameRe("name=\"([^\"]*)\"");
+
+    QString name;
+    const QList<QByteArray> lines = partHeaders.split('\n');
+    for (QByteArray line : lines) {
+        line = line.trimmed();
+        if (line.toLower().startsWith("content-disposition:")) {
+            // 注意不要把filename="..."误认为name
+            QString disposition = QString::fromUtf8(line);
+            QRegularExpressionMatchIterator it = nameRe.globalMatch(disposition);
+            while (it.hasNext()) {
+                QRegularExpressionMatch match = it.next();
+                int start = match.capturedStart(0);
+                if (start == 0 || !disposition.at(start - 1).isLetter()) {
+                    name = match.captured(1);
+                    break;
+                }
+            }
+        }
+    }
+
+    // 只保留第一个文件字段
+    m_inFilePart = !m_file && m_fileFieldNames.contains(name);
+    if (m_inFilePart) {
+        qDebug() << "找到PDF表单字段:" << name << "，开始写入临时文件";
+        m_file = createUploadFile();
+        if (!m_file) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MultipartStreamParser::processPending()
+{
+    while (true) {
+        switch (m_state) {
+        case State::PartData: {
+            int pos = m_pending.indexOf(m_delimiter);
+            if (pos < 0) {
+                // 保留可能是边界前缀的末尾部分，其余数据直接写出
+                qint64 safe = m_pending.size() - (m_delimiter.size() - 1);
+                if (safe > 0) {
+                    if (!writePartData(m_pending.constData(), safe)) {
+                        m_state = State::Error;
+                        return false;
+                    }
+                    m_pending.remove(0, safe);
+                }
+                return true;
+            }
+
+            if (!writePartData(m_pending.constData(), pos)) {
+                m_state = State::Error;
+                return false;
+            }
+            m_pending.remove(0, pos + m_delimiter.size());
+            m_inFilePart = false;
+            m_state = State::AfterDelimiter;
+            break;
+        }
+        case State::AfterDelimiter: {
+            if (m_pending.size() < 2) {
+                return true;
+            }
+            if (m_pending.startsWith("--")) {
+                m_pending.clear();
+                m_state = State::Done;
+                return true;
+            }
+            if (!m_pending.startsWith("\r\n")) {
+                qWarning() << "multipart边界后格式错误";
+                m_state = State::Error;
+                return false;
+            }
+            m_pending.remove(0, 2);
+            m_state = State::PartHeaders;
+            break;
+        }
+        case State::PartHeaders: {
+            int end = m_pending.indexOf("\r\n\r\n");
+            if (end < 0) {
+                if (m_pending.size() > kMaxPartHeaderSize) {
+                    qWarning() << "multipart分段头部过长";
+                    m_state = State::Error;
+                    return false;
+                }
+                return true;
+            }
+            if (!startPart(m_pending.left(end))) {
+                m_state = State::Error;
+                return false;
+            }
+            // 分段数据紧跟空行，数据末尾的CRLF属于下一个边界
+            m_pending.remove(0, end + 4);
+            m_state = State::PartData;
+            break;
+        }
+        case State::Done:
+            return true;
+        case State::Error:
+            return false;
+        }
+    }
+}
+
+bool MultipartStreamParser::finish(RequestHandler::HttpRequest& request)
+{
+    if (m_state != State::Done) {
+        qWarning() << "multipart请求体不完整，未找到结束边界";
+        return false;
+    }
+
+    if (!m_magic.complete(m_fileSize)) {
+        reject(415, "Unsupported Media Type");
+        return false;
+    }
+
+    if (m_file) {
+        m_file->flush();
+        qDebug() << "成功提取PDF数据到临时文件:" << m_file->fileName() << "大小:" << m_fileSize << "字节";
+    } else {
+        qWarning() << "未找到PDF/file表单字段";
+    }
+    request.uploadedFile = m_file;
+    return true;
+}
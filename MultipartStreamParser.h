@@ -0,0 +1,89 @@
+#ifndef MULTIPARTSTREAMPARSER_H
+#define MULTIPARTSTREAMPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <memory>
+#include "HttpRequestParser.h"
+
+// 检查上传文件内容开头的魔数（如"%PDF"），数据可能分多次到达
+class MagicPrefixCheck
+{
+public:
+    void setPrefix(const QByteArray& prefix) { m_prefix = prefix; m_matched = 0; }
+
+    // 送入文件内容，开头与魔数不符时返回false
+    bool feed(const char* data, qint64 size);
+    // 内容已结束：为空或已完整匹配魔数时返回true
+    bool complete(qint64 totalSize) const { return totalSize == 0 || m_matched == m_prefix.size(); }
+
+private:
+    QByteArray m_prefix;
+    int m_matched = 0;
+};
+
+// 把请求体原样写入临时文件（用于application/pdf等非表单上传）
+class TempFileBodySink : public HttpBodySink
+{
+public:
+    TempFileBodySink();
+
+    // 请求体必须以prefix开头，否则在收到开头几个字节时即以415拒绝
+    void setRequiredPrefix(const QByteArray& prefix) { m_magic.setPrefix(prefix); }
+
+    bool write(const char* data, qint64 size) override;
+    bool finish(RequestHandler::HttpRequest& request) override;
+
+private:
+    std::shared_ptr<QTemporaryFile> m_file;
+    bool m_opened = false;
+    qint64 m_size = 0;
+    MagicPrefixCheck m_magic;
+};
+
+// 流式multipart/form-data解析器
+// 随数据到达逐段扫描边界，文件字段（默认pdf/file）的内容直接写入临时文件，
+// 其它字段丢弃，整个请求体不会在内存中保留副本
+class MultipartStreamParser : public HttpBodySink
+{
+public:
+    explicit MultipartStreamParser(const QByteArray& boundary,
+                                   const QStringList& fileFieldNames = QStringList() << "pdf" << "file");
+
+    // 从Content-Type中提取boundary，失败返回空
+    static QByteArray boundaryFromContentType(const QString& contentType);
+
+    // 文件字段内容必须以prefix开头，否则在收到开头几个字节时即以415拒绝
+    void setRequiredPrefix(const QByteArray& prefix) { m_magic.setPrefix(prefix); }
+
+    bool write(const char* data, qint64 size) override;
+    bool finish(RequestHandler::HttpRequest& request) override;
+
+private:
+    enum class State {
+        PartData,        // 在分段数据中查找下一个边界（第一个边界之前的前导数据同样在此跳过）
+        AfterDelimiter,  // 边界之后：--表示结束，CRLF表示新分段
+        PartHeaders,     // 分段头部，直到空行
+        Done,            // 已遇到结束边界
+        Error
+    };
+
+    State m_state = State::PartData;
+    QByteArray m_delimiter;      // "\r\n--" + boundary
+    QByteArray m_pending;        // 尚未处理的数据（可能包含不完整的边界）
+    QStringList m_fileFieldNames;
+
+    // 当前分段是否写入文件
+    bool m_inFilePart = false;
+    std::shared_ptr<QTemporaryFile> m_file;
+    qint64 m_fileSize = 0;
+    MagicPrefixCheck m_magic;
+
+    bool processPending();
+    bool startPart(const QByteArray& partHeaders);
+    bool writePartData(const char* data, qint64 size);
+};
+
+#endif // MULTIPARTSTREAMPARSER_H
@@ -5,8 +5,6 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QTimer>
-#include <QNetworkRequest>
-#include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QHostAddress>
@@ -21,18 +19,10 @@ NavigationDisplayWidget::NavigationDisplayWidget(QWidget *parent)
       m_serverRunning(false),
       m_currentDirection("未设置"),
       m_currentDistance("未知"),
-      m_serverPort(8080),
-      m_networkManager(new QNetworkAccessManager(this)),
-      m_pollTimer(new QTimer(this))
+      m_serverPort(8080)
 {
     setupUI();
 
-    // 设置轮询定时器
-    connect(m_pollTimer, &QTimer::timeout, this, &NavigationDisplayWidget::pollNavData);
-    
-    // 处理网络请求完成信号
-    connect(m_networkManager, &QNetworkAccessManager::finished, this, &NavigationDisplayWidget::handleNetworkReply);
-    
     // 设置日志
     qDebug() << "NavigationDisplayWidget构造完成, 端口:" << m_serverPort << "线程ID:" << QThread::currentThreadId();
 }
@@ -40,10 +30,6 @@ NavigationDisplayWidget::NavigationDisplayWidget(QWidget *parent)
 NavigationDisplayWidget::~NavigationDisplayWidget()
 {
     stopServer();
-
-    if (m_pollTimer) {
-        m_pollTimer->stop();
-    }
     
     qDebug() << "NavigationDisplayWidget已销毁";
 }
@@ -148,15 +134,18 @@ void NavigationDisplayWidget::startServer()
     m_serverRunning = true;
     updateStatusDisplay("服务器已启动");
     
-    // 启动轮询定时器
-    m_pollTimer->start(5000); // 每5秒轮询一次
-    
     // 设置显示信息
     updateDirectionImage("未设置");
     m_directionLabel->setText("方向: 未设置");
     m_distanceLabel->setText("距离: 未知");
     
     emit navigationUpdated("未设置", "未知");
+
+    // 导航已在进行时立即显示当前状态，不必等下一次更新
+    if (m_navigationStore) {
+        m_appliedVersion = 0;
+        applyNavigationState();
+    }
 }
 
 void NavigationDisplayWidget::stopServer()
@@ -168,9 +157,6 @@ void NavigationDisplayWidget::stopServer()
     
     qDebug() << "停止导航服务";
     
-    // 停止轮询定时器
-    m_pollTimer->stop();
-    
     // 更新状态
     m_serverRunning = false;
     updateStatusDisplay("服务器已停止");
@@ -183,156 +169,63 @@ void NavigationDisplayWidget::stopServer()
     emit navigationUpdated("未设置", "未知");
 }
 
-void NavigationDisplayWidget::pollNavData()
+void NavigationDisplayWidget::setNavigationStore(NavigationStateStore *store)
 {
-    // 如果服务器未运行，不进行轮询
-    if (!m_serverRunning) {
+    if (m_navigationStore == store) {
         return;
     }
-    
-    qDebug() << "正在轮询导航数据，端口:" << m_serverPort;
-    
-    // 创建轮询请求
-    QUrl url(QString("http://localhost:%1/api/navigation/data").arg(m_serverPort));
-    QNetworkRequest request(url);
-    
-    // 添加超时设置
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
-    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Connection", "keep-alive");
-    
-    // 添加时间戳防止缓存
-    url.setQuery(QString("t=%1").arg(QDateTime::currentMSecsSinceEpoch()));
-    request.setUrl(url);
-    
-    // 发送请求
-    QNetworkReply *reply = m_networkManager->get(request);
-    
-    // 处理错误
-    connect(reply, &QNetworkReply::errorOccurred, [this, reply](QNetworkReply::NetworkError code) {
-        QString errorString = reply->errorString();
-        qDebug() << "网络错误:" << errorString;
-        
-        // 如果是连接关闭错误，不需要更新界面状态，这是HTTP正常行为
-        if (errorString.contains("Connection closed")) {
-            qDebug() << "服务器关闭了连接，这是正常现象";
-        } else {
-            updateStatusDisplay(QString("错误: %1").arg(errorString));
-        }
-    });
-    
-    // 处理完成信号已在构造函数中连接
-}
-
-void NavigationDisplayWidget::handleNetworkReply(QNetworkReply *reply)
-{
-    qDebug() << "收到网络响应";
-    
-    // 检查回复是否有效
-    if (!reply) {
-        qDebug() << "网络回复为空";
-        return;
+    if (m_navigationStore) {
+        disconnect(m_navigationStore, nullptr, this, nullptr);
     }
-    
-    // 检查错误
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "网络错误:" << reply->errorString();
-        // 连接关闭是HTTP的正常行为，不需要特别处理
-        if (!reply->errorString().contains("Connection closed")) {
-            updateStatusDisplay(QString("错误: %1").arg(reply->errorString()));
-        }
-        reply->deleteLater();
-        return;
-    }
-    
-    // 处理数据为空的情况
-    if (reply->size() == 0) {
-        qDebug() << "响应数据为空";
-        reply->deleteLater();
+
+    m_navigationStore = store;
+    m_appliedVersion = 0;
+    if (!m_navigationStore) {
         return;
     }
-    
-    // 获取响应数据
-    QByteArray responseData = reply->readAll();
-    
-    // 输出响应数据（调试用）
-    qDebug() << "响应数据:" << responseData;
-    
-    // 尝试解析JSON
-    QJsonParseError jsonError;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData, &jsonError);
-    
-    if (jsonError.error != QJsonParseError::NoError) {
-        qDebug() << "JSON解析错误:" << jsonError.errorString();
-        qDebug() << "原始数据:" << responseData;
-        reply->deleteLater();
-        return;
+
+    // 状态对象在GUI线程发出合并后的通知
+    connect(m_navigationStore, &NavigationStateStore::changed, this, &NavigationDisplayWidget::applyNavigationState);
+    if (m_serverRunning) {
+        applyNavigationState();
     }
-    
-    // 确保是一个JSON对象
-    if (!jsonDoc.isObject()) {
-        qDebug() << "响应不是有效的JSON对象";
-        reply->deleteLater();
+}
+
+void NavigationDisplayWidget::applyNavigationState()
+{
+    if (!m_navigationStore) {
         return;
     }
-    
-    QJsonObject navDataObj = jsonDoc.object();
-    
-    // 检查错误字段
-    if (navDataObj.contains("error") && navDataObj["error"].toBool()) {
-        QString errorMessage = navDataObj["message"].toString();
-        qDebug() << "API返回错误:" << errorMessage;
-        updateStatusDisplay(QString("API错误: %1").arg(errorMessage));
-        reply->deleteLater();
+
+    const NavigationState state = m_navigationStore->snapshot();
+    if (state.version == m_appliedVersion) {
         return;
     }
-    
-    // 检查导航数据
-    if (navDataObj.contains("direction") && navDataObj.contains("distance")) {
-        QString direction = navDataObj["direction"].toString();
-        QString distance = navDataObj["distance"].toString();
-        bool active = navDataObj.contains("active") ? navDataObj["active"].toBool() : false;
-        
-        // 只有在状态为活动时才更新导航信息
-        if (active) {
-            qDebug() << "更新导航信息 - 方向:" << direction << "距离:" << distance;
-            updateNavigation(direction, distance);
-        } else {
-            qDebug() << "导航未激活，不更新显示";
-        }
+    m_appliedVersion = state.version;
+
+    // 停止导航时状态已恢复为默认值，同样需要刷新显示；未激活的初始状态保持当前显示
+    if (state.active || state.version > 1) {
+        updateNavigation(state.direction, state.distance);
+        updateStatusDisplay("数据已更新");
     }
-    
-    // 更新状态显示
-    updateStatusDisplay("数据已更新");
-    
-    // 释放网络回复对象
-    reply->deleteLater();
 }
 
 void NavigationDisplayWidget::updateNavigation(const QString &direction, const QString &distance)
 {
-    qDebug() << "NavigationDisplayWidget::updateNavigation被调用 - 方向:" << direction 
-             << "距离:" << distance;
-
     // 更新成员变量
     m_currentDirection = direction;
     m_currentDistance = distance;
 
-    // 确保在主线程中更新UI
-    QMetaObject::invokeMethod(this, [this, direction, distance]() {
-        // 直接在lambda中操作UI元素，确保在主线程执行
-        m_directionLabel->setText(QString("方向: %1").arg(direction));
-        m_distanceLabel->setText(QString("距离: %1").arg(distance));
-
-        // 更新方向图像
-        updateDirectionImage(direction);
+    // 调用方（NavigationStateStore的合并通知、测试按钮）都在GUI线程，直接刷新；
+    // 高频更新已由NavigationStateStore合并，这里不再经过队列
+    m_directionLabel->setText(QString("方向: %1").arg(direction));
+    m_distanceLabel->setText(QString("距离: %1").arg(distance));
 
-        // 刷新界面确保显示
-        this->update();
+    // 更新方向图像
+    updateDirectionImage(direction);
 
-        qDebug() << "UI更新完成 - 方向:" << direction << "距离:" << distance;
-    }, Qt::QueuedConnection);
+    // 刷新界面确保显示
+    this->update();
 
     // 发送信号
     emit navigationUpdated(direction, distance);
@@ -8,8 +8,6 @@
 #include <QHBoxLayout>
 #include <QTimer>
 #include <QComboBox>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -21,6 +19,7 @@
 #include <QShowEvent>
 #include <QHideEvent>
 #include "CameraResourceManager.h"  // 添加中央摄像头管理器
+#include "NavigationStateStore.h"
 class NavigationDisplayWidget : public QWidget
 {
     Q_OBJECT
@@ -29,6 +28,9 @@ public:
     explicit NavigationDisplayWidget(QWidget *parent = nullptr);
     ~NavigationDisplayWidget();
 
+    // 订阅导航状态：状态变化时立即刷新显示（多次连续更新合并为一次）
+    void setNavigationStore(NavigationStateStore* store);
+
 signals:
     void backButtonClicked();
     void navigationUpdated(const QString &direction, const QString &distance);
@@ -37,8 +39,6 @@ public slots:
     void startServer();
     void stopServer();
     void updateNavigation(const QString &direction, const QString &distance);
-    void handleNetworkReply(QNetworkReply *reply);
-    void pollNavData();
     void onBackButtonClicked();
 
 protected:
@@ -47,7 +47,8 @@ protected:
     void hideEvent(QHideEvent *event) override;
 
 private slots:
-    
+    // 状态对象通知有新数据，读取快照并刷新
+    void applyNavigationState();
 
 private:
     // UI Elements
@@ -63,10 +64,10 @@ private:
     QString m_currentDirection;
     QString m_currentDistance;
     
-    // Network
-    QNetworkAccessManager *m_networkManager;
-    QTimer *m_pollTimer;
-    
+    // 导航状态来源，以及已显示的版本（版本未变时不重复刷新）
+    NavigationStateStore *m_navigationStore = nullptr;
+    quint64 m_appliedVersion = 0;
+
     // Server details
     int m_serverPort;
     
@@ -0,0 +1,61 @@
+#include "NavigationStateStore.h"
+#include <QMutexLocker>
+
+NavigationStateStore::NavigationStateStore(QObject* parent)
+    : QObject(parent)
+{
+    m_state.updatedAt = QDateTime::currentDateTime();
+}
+
+NavigationState NavigationStateStore::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_state;
+}
+
+void NavigationStateStore::update(const QString& direction, const QString& distance)
+{
+    QMutexLocker locker(&m_mutex);
+    m_state.direction = direction;
+    m_state.distance = distance;
+    m_state.active = true;
+    markChangedLocked();
+}
+
+void NavigationStateStore::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_state.direction = "未设置";
+    m_state.distance = "未知";
+    m_state.active = false;
+    markChangedLocked();
+}
+
+void NavigationStateStore::setActive(bool active)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_state.active == active) {
+        return;
+    }
+    m_state.active = active;
+    markChangedLocked();
+}
+
+void NavigationStateStore::markChangedLocked()
+{
+    m_state.version++;
+    m_state.updatedAt = QDateTime::currentDateTime();
+    m_version.store(m_state.version, std::memory_order_release);
+
+    // 只在没有待发通知时投递，接收方处理时读取的已是最新状态
+    if (!m_notifyPending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, "deliverChange", Qt::QueuedConnection);
+    }
+}
+
+void NavigationStateStore::deliverChange()
+{
+    // 先清除标志再发信号：处理期间的新修改会再投递一次，不会丢失
+    m_notifyPending.store(false, std::memory_order_release);
+    emit changed(version());
+}
@@ -0,0 +1,56 @@
+#ifndef NAVIGATIONSTATESTORE_H
+#define NAVIGATIONSTATESTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QDateTime>
+#include <QMutex>
+#include <atomic>
+
+// 导航状态快照
+struct NavigationState {
+    QString direction = "未设置";
+    QString distance = "未知";
+    bool active = false;
+    // 每次修改递增，用于ETag和判断是否有新数据
+    quint64 version = 1;
+    QDateTime updatedAt;
+};
+
+// 进程内的导航状态：HTTP工作线程写入，界面直接订阅，不再经本机HTTP轮询。
+// 任意线程可读写；连续多次修改只在本对象所在线程触发一次changed()，
+// 接收方通过snapshot()取得最新值
+class NavigationStateStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NavigationStateStore(QObject* parent = nullptr);
+
+    NavigationState snapshot() const;
+    quint64 version() const { return m_version.load(std::memory_order_acquire); }
+
+    // 更新方向和距离，导航随之激活
+    void update(const QString& direction, const QString& distance);
+    // 停止导航，恢复默认显示
+    void stop();
+    void setActive(bool active);
+
+signals:
+    // 状态已变化（合并通知），version为发出时的最新版本
+    void changed(quint64 version);
+
+private slots:
+    void deliverChange();
+
+private:
+    mutable QMutex m_mutex;
+    NavigationState m_state;
+    std::atomic<quint64> m_version{1};
+    // 已投递但尚未发出的通知，期间的修改不再重复投递
+    std::atomic<bool> m_notifyPending{false};
+
+    // 在持锁状态下调用：递增版本并投递通知
+    void markChangedLocked();
+};
+
+#endif // NAVIGATIONSTATESTORE_H
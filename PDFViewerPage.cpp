@@ -1,5 +1,6 @@
 // PDFViewerPage.cpp
 #include "PDFViewerPage.h"
+#include "Metrics.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QVBoxLayout>
@@ -22,7 +23,17 @@ PDFViewerPage::PDFViewerPage(QWidget *parent)
       camera(nullptr),
       cameraAvailable(false),
       maxCacheSize(5),
-      lastRequestedPage(-1)
+      lastRequestedPage(-1),
+      m_frameMailbox(this, [this](const DisplayFrame& frame) { showProcessedFrame(frame); }),
+      m_statusMailbox(this, [](const std::function<void()>& update) { update(); }),
+      m_performanceMailbox(this, [this](const qint64& processTime) {
+          if (m_performanceLabel) {
+              m_performanceLabel->setText(QString("处理时间: %1 ms | FPS: %2 | 模式: %3")
+                  .arg(processTime)
+                  .arg(m_currentFps, 0, 'f', 1)
+                  .arg(m_lowPerformanceMode ? "低性能" : "标准"));
+          }
+      })
 {
     setupUI();
     // Initialize Kalman filter parameters
@@ -32,6 +43,14 @@ PDFViewerPage::PDFViewerPage(QWidget *parent)
     //setupCamera();  // Remove this line to prevent auto initialization
     // 初始化陀螺仪
     initGyroscope();
+
+    // 预加载期间翻页的请求不丢弃，结束后按最新的页重新预加载
+    connect(&m_preloadWatcher, &QFutureWatcher<void>::finished, this, [this]() {
+        if (m_pendingPreloadPage >= 0) {
+            m_pendingPreloadPage = -1;
+            preloadAdjacentPages();
+        }
+    });
 }
 
 void PDFViewerPage::setupKalmanFilter()
@@ -98,6 +117,11 @@ PDFViewerPage::~PDFViewerPage()
         m_arucoProcessor->stop();
         m_arucoProcessor->wait();
     }
+
+    // 文档须在m_networkPdf释放文件映射之前关闭
+    m_preloadFuture.waitForFinished();
+    delete pdfDocument;
+    pdfDocument = nullptr;
 }
 
 void PDFViewerPage::setupUI()
@@ -780,32 +804,37 @@ void PDFViewerPage::resetDesktopDetection()
 }
 
 
-void PDFViewerPage::networkLoadPDF(const QByteArray& pdfData)
+void PDFViewerPage::networkLoadPDF(std::shared_ptr<UploadedPdf> pdf)
 {
-    if (pdfData.isEmpty()) {
+    if (!pdf || !pdf->document()) {
         statusLabel->setText("接收到的PDF数据为空");
         return;
     }
-    
-    statusLabel->setText("从网络接收PDF数据...");
-    
-    // 创建临时文件保存接收到的PDF数据
-    QTemporaryFile tempFile;
-    if (!tempFile.open()) {
-        statusLabel->setText("无法创建临时文件");
-        return;
+
+    // 后台预加载仍在使用旧文档，先等待其结束，再清除旧文档的页面缓存
+    m_preloadFuture.waitForFinished();
+    {
+        QMutexLocker locker(&pdfCacheMutex);
+        pdfPageCache.clear();
     }
-    
-    // 写入PDF数据
-    tempFile.write(pdfData);
-    tempFile.flush();
-    
-    // 加载PDF文件
-    if (pdfDocument->load(tempFile.fileName()) != QPdfDocument::Error::None) {
-        statusLabel->setText("PDF加载失败");
-        return;
+    for (int i = 0; i < pdfDocument->pageCount(); ++i) {
+        ResourceManager::instance().clearCacheEntry(QString("pdf_page_%1").arg(i));
     }
-    
+    currentPdfFrame = QImage();
+
+    // 文档已在上传请求中打开并检查，由本页面接管，始终只保留一个文档对象
+    QPdfDocument* previous = pdfDocument;
+    pdfDocument = pdf->takeDocument();
+    pdfDocument->setParent(this);
+    delete previous;
+
+    // 旧文档已关闭，此时才释放其文件映射
+    m_networkPdf = std::move(pdf);
+    onNetworkPDFLoaded();
+}
+
+void PDFViewerPage::onNetworkPDFLoaded()
+{
     // 设置初始页面
     currentPage = 0;
     
@@ -1533,13 +1562,20 @@ void PDFViewerPage::renderCurrentPDFToImage(const QSize& targetSize)
 // 预加载相邻页面
 void PDFViewerPage::preloadAdjacentPages()
 {
-    // 在后台线程中预加载相邻页面
-    QtConcurrent::run([this]() {
+    // 上一次预加载尚未结束时只记下目标页，结束后再预加载（多次翻页只保留最新的一次）
+    if (m_preloadFuture.isRunning()) {
+        m_pendingPreloadPage = currentPage;
+        return;
+    }
+
+    // 在后台线程中预加载相邻页面，目标页在提交时确定
+    const int targetPage = currentPage;
+    m_preloadFuture = QtConcurrent::run([this, targetPage]() {
         QMutexLocker locker(&pdfCacheMutex);
         
         // 预加载前后各一页
         for (int offset = -1; offset <= 1; offset += 2) {
-            int pageToLoad = currentPage + offset;
+            int pageToLoad = targetPage + offset;
             
             // 检查页码是否有效
             if (pageToLoad >= 0 && pageToLoad < pdfDocument->pageCount() && !pdfPageCache.contains(pageToLoad)) {
@@ -1550,8 +1586,8 @@ void PDFViewerPage::preloadAdjacentPages()
                     int maxDistance = -1;
                     
                     for (auto it = pdfPageCache.begin(); it != pdfPageCache.end(); ++it) {
-                        int distance = std::abs(it.key() - currentPage);
-                        if (distance > maxDistance && it.key() != currentPage) {
+                        int distance = std::abs(it.key() - targetPage);
+                        if (distance > maxDistance && it.key() != targetPage) {
                             maxDistance = distance;
                             furthestPage = it.key();
                         }
@@ -1578,6 +1614,7 @@ void PDFViewerPage::preloadAdjacentPages()
             }
         }
     });
+    m_preloadWatcher.setFuture(m_preloadFuture);
 }
 
 // 环境光照分析和调整
@@ -2205,9 +2242,9 @@ void PDFViewerPage::updateDeskPosition(const std::vector<cv::Point>& contour)
         if (statusLabel) {
             // 计算距离桌面的距离用于调试
             double distance = cv::norm(tvec);
-            QMetaObject::invokeMethod(this, [this, distance]() {
+            m_statusMailbox.post([this, distance]() {
                 statusLabel->setText(QString("桌面跟踪中 - 距离: %.2f cm").arg(distance * 0.1));
-            }, Qt::QueuedConnection);
+            });
         }
         
     } catch (const std::exception& e) {
@@ -3495,14 +3532,10 @@ void PDFViewerPage::handleDetectedMarkers(const std::vector<int>& ids,
  QImage displayImageCopy = displayImage.copy();
  
  // Update UI (in main thread)
- QMetaObject::invokeMethod(this, [this, displayImageCopy]() {
-     processedLabel->setPixmap(QPixmap::fromImage(displayImageCopy)
-                             .scaled(processedLabel->size(), Qt::KeepAspectRatio, 
-                                    Qt::SmoothTransformation));
- }, Qt::QueuedConnection);
+ m_frameMailbox.post({displayImageCopy, Qt::SmoothTransformation});
  
  // Update status message based on marker detection
- QMetaObject::invokeMethod(this, [this, markersDetected]() {
+ m_statusMailbox.post([this, markersDetected]() {
      if (markersDetected) {
          statusLabel->setText(QString("检测到标记 - 正在显示页面 %1/%2").arg(currentPage + 1).arg(pdfDocument->pageCount()));
      } else if (!markersDetected && markerLostTimer.elapsed() < 3000) {
@@ -3510,7 +3543,7 @@ void PDFViewerPage::handleDetectedMarkers(const std::vector<int>& ids,
      } else {
          statusLabel->setText("未检测到标记 - 请确保ArUco标记在摄像头视野内");
      }
- }, Qt::QueuedConnection);
+ });
 }
 
 
@@ -3873,6 +3906,14 @@ void PDFViewerPage::processFrameInThreadPool(const QVideoFrame &frame)
             }
             double avgTime = totalTime / static_cast<double>(m_frameTimes.size());
             m_currentFps = (avgTime > 0) ? 1000.0 / avgTime : 0.0;
+
+            // 导出到/metrics
+            static MetricHistogram* frameLatency = MetricsRegistry::instance().histogram(
+                "pdf_frame_processing_seconds", "PDFViewerPage frame processing time in the thread pool");
+            static MetricGauge* frameFps = MetricsRegistry::instance().gauge(
+                "pdf_frame_processing_fps", "PDFViewerPage frames per second derived from recent processing times");
+            frameLatency->observe(processTime / 1000.0);
+            frameFps->set(m_currentFps);
             
             // 根据性能自动调整处理质量
             adjustProcessingQuality();
@@ -3882,14 +3923,7 @@ void PDFViewerPage::processFrameInThreadPool(const QVideoFrame &frame)
             m_frameProcessedCondition.wakeAll();
             
             // 更新UI上的性能指标显示
-            QMetaObject::invokeMethod(this, [this, processTime]() {
-                if (m_performanceLabel) {
-                    m_performanceLabel->setText(QString("处理时间: %1 ms | FPS: %2 | 模式: %3")
-                        .arg(processTime)
-                        .arg(m_currentFps, 0, 'f', 1)
-                        .arg(m_lowPerformanceMode ? "低性能" : "标准"));
-                }
-            }, Qt::QueuedConnection);
+            m_performanceMailbox.post(processTime);
             
         } catch (const std::exception& e) {
             qWarning() << "线程池处理帧异常:" << e.what();
@@ -3956,11 +3990,7 @@ void PDFViewerPage::processHighResFrame(const cv::Mat& frame)
                           processedFrame.step, QImage::Format_BGR888);
         QImage displayImageCopy = displayImage.copy();
         
-        QMetaObject::invokeMethod(this, [this, displayImageCopy]() {
-            processedLabel->setPixmap(QPixmap::fromImage(displayImageCopy)
-                                     .scaled(processedLabel->size(), Qt::KeepAspectRatio, 
-                                             Qt::SmoothTransformation));
-        }, Qt::QueuedConnection);
+        m_frameMailbox.post({displayImageCopy, Qt::SmoothTransformation});
                 
         // 将帧发送到ArUco处理线程
         m_arucoProcessor->processFrame(frame);
@@ -4004,10 +4034,7 @@ void PDFViewerPage::processLowResFrame(const cv::Mat& frame)
                           processedFrame.step, QImage::Format_BGR888);
         QImage displayImageCopy = displayImage.copy();
         
-        QMetaObject::invokeMethod(this, [this, displayImageCopy]() {
-            processedLabel->setPixmap(QPixmap::fromImage(displayImageCopy)
-                                     .scaled(processedLabel->size(), Qt::KeepAspectRatio));
-        }, Qt::QueuedConnection);
+        m_frameMailbox.post({displayImageCopy, Qt::FastTransformation});
         
     } catch (const std::exception& e) {
         qWarning() << "低分辨率帧处理异常:" << e.what();
@@ -4016,6 +4043,15 @@ void PDFViewerPage::processLowResFrame(const cv::Mat& frame)
     }
 }
 
+void PDFViewerPage::showProcessedFrame(const DisplayFrame& frame)
+{
+    if (!processedLabel) {
+        return;
+    }
+    processedLabel->setPixmap(QPixmap::fromImage(frame.image)
+                             .scaled(processedLabel->size(), Qt::KeepAspectRatio, frame.mode));
+}
+
 // 根据性能自动调整处理质量
 void PDFViewerPage::adjustProcessingQuality()
 {
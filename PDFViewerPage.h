@@ -10,6 +10,7 @@
 #include <QMediaCaptureSession>
 #include <QVideoSink>
 #include <QPdfDocument>
+#include <memory>
 #include <QSlider>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
@@ -35,12 +36,15 @@
 #include <string>
 #include <QCheckBox>
 #include <QThread>
+#include "LatestValueMailbox.h"
+#include "UploadedPdf.h"
 #include <QMutex>
 #include <QWaitCondition>
 #include <QQueue>
 #include <QImageReader>
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
+#include <QFutureWatcher>
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include "ThreadPool.h"
@@ -212,6 +216,10 @@ public:
     explicit PDFViewerPage(QWidget *parent = nullptr);
     ~PDFViewerPage();
 
+    // 当前页码（从1开始）和总页数，供控制通道上报状态
+    int currentPageNumber() const { return currentPage + 1; }
+    int pageCount() const { return pdfDocument ? pdfDocument->pageCount() : 0; }
+
     void setupCamera();
     void startCamera();
     void stopCamera();
@@ -259,7 +267,7 @@ protected:
 
 public slots:
     void resetDesktopDetection();
-    void networkLoadPDF(const QByteArray& pdfData);
+    void networkLoadPDF(std::shared_ptr<UploadedPdf> pdf);
     void onBackButtonClicked();
     void processFrame(const QVideoFrame &frame);
     void nextPage();
@@ -302,6 +310,9 @@ private:
     // PDF相关
     QPdfDocument *pdfDocument;
     int currentPage = 0;
+    // 网络上传的PDF：文档已在后台线程打开，由pdfDocument接管；此处保持其文件映射
+    std::shared_ptr<UploadedPdf> m_networkPdf;
+    void onNetworkPDFLoaded();
     QImage currentPdfFrame;
     void renderCurrentPDFToImage(const QSize& targetSize);
     std::vector<cv::Point2f> pdfCorners;
@@ -437,6 +448,12 @@ private:
     int lastRequestedPage;
 
     void preloadAdjacentPages();
+    // 正在进行的后台预加载，替换或释放文档前须等待其结束
+    QFuture<void> m_preloadFuture;
+    // 预加载结束时通知界面线程，处理期间到达的预加载请求
+    QFutureWatcher<void> m_preloadWatcher;
+    // 预加载进行期间翻到的最新页，-1表示没有等待的请求
+    int m_pendingPreloadPage = -1;
 
 
     // 陀螺仪数据相关
@@ -483,6 +500,16 @@ private:
     // PDFViewerPage类中添加的UI控制
     QCheckBox* m_useThreadPoolCheckbox;        // 线程池开关
     QLabel* m_performanceLabel;                // 性能指标显示
+
+    // 处理线程发往界面的更新：每种只保留最新值，界面线程每轮事件循环最多刷新一次
+    struct DisplayFrame {
+        QImage image;
+        Qt::TransformationMode mode;
+    };
+    LatestValueMailbox<DisplayFrame> m_frameMailbox;           // 处理后的画面
+    LatestValueMailbox<std::function<void()>> m_statusMailbox; // 状态栏文字
+    LatestValueMailbox<qint64> m_performanceMailbox;           // 单帧处理时间（毫秒）
+    void showProcessedFrame(const DisplayFrame& frame);
 };
 
 #endif // PDFVIEWERPAGE_H
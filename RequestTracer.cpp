@@ -0,0 +1,200 @@
+#include "RequestTracer.h"
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QDebug>
+#include <chrono>
+
+namespace {
+// 环形缓冲区保存的区间数量
+const size_t kEventCapacity = 65536;
+const quint32 kFullThreshold = 1u << 24;
+
+thread_local RequestTracer::Context t_current;
+
+// 导出时间以进程内第一次使用追踪器为原点
+const qint64 kOriginNs = RequestTracer::nowNs();
+}
+
+RequestTracer::Scope::Scope(const Context& context)
+    : m_previous(t_current)
+{
+    t_current = context;
+}
+
+RequestTracer::Scope::~Scope()
+{
+    t_current = m_previous;
+}
+
+RequestTracer::Span::Span(const Context& context, const char* name)
+    : m_context(context),
+      m_name(name)
+{
+    if (m_context.sampled) {
+        m_startNs = nowNs();
+    }
+}
+
+RequestTracer::Span::Span(const char* name)
+    : Span(t_current, name)
+{
+}
+
+RequestTracer::Span::~Span()
+{
+    if (m_context.sampled) {
+        RequestTracer::instance().record(m_context, m_name, m_startNs, nowNs());
+    }
+}
+
+RequestTracer& RequestTracer::instance()
+{
+    static RequestTracer tracer;
+    return tracer;
+}
+
+RequestTracer::RequestTracer()
+{
+    const QByteArray envRate = qgetenv("AR_TRACE_SAMPLE_RATE");
+    if (!envRate.isEmpty()) {
+        bool ok = false;
+        double rate = envRate.toDouble(&ok);
+        if (ok) {
+            setSampleRate(rate);
+            qInfo() << "请求追踪采样率:" << sampleRate();
+        }
+    }
+}
+
+void RequestTracer::setSampleRate(double rate)
+{
+    rate = qBound(0.0, rate, 1.0);
+    quint32 threshold = static_cast<quint32>(rate * kFullThreshold);
+    // 很小但非零的采样率至少保留一个名额，避免被取整为关闭
+    if (rate > 0.0 && threshold == 0) {
+        threshold = 1;
+    }
+    m_threshold.store(threshold, std::memory_order_relaxed);
+}
+
+double RequestTracer::sampleRate() const
+{
+    return static_cast<double>(m_threshold.load(std::memory_order_relaxed)) / kFullThreshold;
+}
+
+RequestTracer::Context RequestTracer::beginRequest()
+{
+    Context context;
+    context.requestId = m_nextRequestId.fetch_add(1, std::memory_order_relaxed);
+
+    quint32 threshold = m_threshold.load(std::memory_order_relaxed);
+    if (threshold != 0) {
+        // 按ID散列决定，采样的请求在时间上均匀分布
+        quint64 hash = context.requestId * 0x9E3779B97F4A7C15ULL;
+        context.sampled = static_cast<quint32>(hash >> 40) < threshold;
+    }
+    return context;
+}
+
+RequestTracer::Context RequestTracer::current()
+{
+    return t_current;
+}
+
+qint64 RequestTracer::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RequestTracer::record(const Context& context, const char* name, qint64 startNs, qint64 endNs)
+{
+    if (!context.sampled) {
+        return;
+    }
+
+    Event event{context.requestId, name, startNs, qMax<qint64>(0, endNs - startNs),
+                static_cast<quint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()))};
+
+    QMutexLocker locker(&m_mutex);
+    if (m_events.size() < kEventCapacity) {
+        m_events.push_back(event);
+        return;
+    }
+    m_events[m_nextEvent] = event;
+    m_nextEvent = (m_nextEvent + 1) % kEventCapacity;
+    m_wrapped = true;
+}
+
+QByteArray RequestTracer::exportChromeTrace(bool clear)
+{
+    std::vector<Event> events;
+    bool wrapped = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        // 按时间顺序取出：已覆盖过时从最旧的位置开始
+        events.reserve(m_events.size());
+        events.insert(events.end(), m_events.begin() + m_nextEvent, m_events.end());
+        events.insert(events.end(), m_events.begin(), m_events.begin() + m_nextEvent);
+        wrapped = m_wrapped;
+        if (clear) {
+            m_events.clear();
+            m_nextEvent = 0;
+            m_wrapped = false;
+        }
+    }
+
+    // 每个请求一行（tid为请求ID），同一请求在不同线程上的阶段显示在一起，
+    // 实际执行线程放在args中
+    QByteArray out;
+    out.reserve(static_cast<int>(events.size()) * 128 + 128);
+    out.append("{\"traceEvents\":[");
+
+    QSet<quint64> namedRequests;
+    bool first = true;
+    for (const Event& event : events) {
+        if (!first) {
+            out.append(',');
+        }
+        first = false;
+
+        if (!namedRequests.contains(event.requestId)) {
+            namedRequests.insert(event.requestId);
+            out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+            out.append(QByteArray::number(event.requestId));
+            out.append(",\"args\":{\"name\":\"request ");
+            out.append(QByteArray::number(event.requestId));
+            out.append("\"}},");
+        }
+
+        out.append("{\"name\":\"");
+        out.append(event.name);
+        out.append("\",\"cat\":\"http\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        out.append(QByteArray::number(event.requestId));
+        out.append(",\"ts\":");
+        out.append(QByteArray::number((event.startNs - kOriginNs) / 1000.0, 'f', 3));
+        out.append(",\"dur\":");
+        out.append(QByteArray::number(event.durationNs / 1000.0, 'f', 3));
+        out.append(",\"args\":{\"request\":");
+        out.append(QByteArray::number(event.requestId));
+        out.append(",\"thread\":");
+        out.append(QByteArray::number(event.threadId));
+        out.append("}}");
+    }
+
+    out.append("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"sampleRate\":");
+    out.append(QByteArray::number(sampleRate()));
+    out.append(",\"truncated\":");
+    out.append(wrapped ? "true" : "false");
+    out.append("}}");
+    return out;
+}
+
+void RequestTracer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_nextEvent = 0;
+    m_wrapped = false;
+}
@@ -0,0 +1,97 @@
+#ifndef REQUESTTRACER_H
+#define REQUESTTRACER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// 请求追踪：每个请求分配一个ID，按采样率记录各处理阶段（读取、解析、路由、数据库、序列化、写出）
+// 的耗时区间，按需导出为Chrome trace-event JSON（chrome://tracing或Perfetto可直接打开）。
+// 采样率为0（默认）时每个阶段只多一次布尔判断，不读时钟也不加锁
+class RequestTracer
+{
+public:
+    // 随请求传递的追踪上下文
+    struct Context {
+        quint64 requestId = 0;
+        bool sampled = false;
+    };
+
+    // 在当前线程上设置正在处理的请求，析构时恢复；
+    // 不接收请求对象的模块（如DatabaseWorker）通过current()取得上下文
+    class Scope
+    {
+    public:
+        explicit Scope(const Context& context);
+        ~Scope();
+
+    private:
+        Context m_previous;
+    };
+
+    // 耗时区间：构造时记开始时间，析构时记录；未采样时不做任何事。
+    // name必须是字符串字面量（只保存指针）
+    class Span
+    {
+    public:
+        Span(const Context& context, const char* name);
+        explicit Span(const char* name);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        Context m_context;
+        const char* m_name;
+        qint64 m_startNs = 0;
+    };
+
+    static RequestTracer& instance();
+
+    // 采样率0~1，0表示关闭；初始值可由环境变量AR_TRACE_SAMPLE_RATE设置
+    void setSampleRate(double rate);
+    double sampleRate() const;
+    bool enabled() const { return m_threshold.load(std::memory_order_relaxed) != 0; }
+
+    // 为新请求分配ID并决定是否采样
+    Context beginRequest();
+
+    // 当前线程正在处理的请求
+    static Context current();
+
+    // 单调时钟（纳秒）
+    static qint64 nowNs();
+
+    // 记录一个已结束的区间，name要求同Span
+    void record(const Context& context, const char* name, qint64 startNs, qint64 endNs);
+
+    // 导出缓冲区中的区间（Chrome trace-event JSON对象格式），clear为true时导出后清空
+    QByteArray exportChromeTrace(bool clear);
+    void clear();
+
+private:
+    RequestTracer();
+
+    struct Event {
+        quint64 requestId;
+        const char* name;
+        qint64 startNs;
+        qint64 durationNs;
+        quint64 threadId;
+    };
+
+    // 采样阈值：请求ID散列的低24位小于阈值时采样，0为关闭，1<<24为全部采样
+    std::atomic<quint32> m_threshold{0};
+    std::atomic<quint64> m_nextRequestId{1};
+
+    // 只有采样的请求才会写入，加锁的开销可以接受；满时覆盖最旧的区间
+    QMutex m_mutex;
+    std::vector<Event> m_events;
+    size_t m_nextEvent = 0;
+    bool m_wrapped = false;
+};
+
+#endif // REQUESTTRACER_H
@@ -6,159 +6,415 @@
 #include <QJsonArray>
 #include <QDebug>
 #include <QDateTime>
+#include <QDir>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QLocale>
+#include <QStandardPaths>
+#include <QTimeZone>
 
 RequestHandler::RequestHandler(DatabaseWorker* dbWorker, QObject* parent) 
     : QObject(parent), 
       m_dbWorker(dbWorker),
-      m_navigationWidget(nullptr),
-      m_currentDirection("未设置"),
-      m_currentDistance("未知"),
-      m_navigationActive(false)
-{
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^POST /api/execute-sql/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleExecuteSQL(req); }
-        )
-    );
-    // 原有API路由 - 使用std::map的insert方法而不是QMap的insert方法
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/data/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleGetData(req); }
-        )
-    );
-
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^POST /api/data/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handlePostData(req); }
-        )
-    );
-    
-    // 新增导航相关API路由
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/navigation/data/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleGetNavigationData(req); }
-        )
-    );
-    
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^POST /api/navigation/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handlePostNavigationData(req); }
-        )
-    );
-    
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/navigation/register/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleRegisterNavigation(req); }
-        )
-    );
-    
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/navigation/unregister/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleUnregisterNavigation(req); }
-        )
-    );
-    
-    // 增加CORS支持的OPTIONS请求处理
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^OPTIONS", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ 
-                HttpResponse response;
-                response.headers.insert("Access-Control-Allow-Origin", "*");
-                response.headers.insert("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-                response.headers.insert("Access-Control-Allow-Headers", "Content-Type, Authorization");
-                response.headers.insert("Access-Control-Max-Age", "86400"); // 24小时
-                response.content = "";
-                return response;
+      m_navigationWidget(nullptr)
+{
+    // 上传文件通过信号跨线程传递
+    qRegisterMetaType<std::shared_ptr<UploadedPdf>>();
+
+    m_etagEpoch = QString::number(QDateTime::currentMSecsSinceEpoch(), 36);
+
+    // VisionPage::captureAndSendImage保存截图的目录
+    setMediaRoot(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation) + "/VisionApp");
+
+    // 延迟响应按路由类别在各自的线程池执行：交互线程池只承载控制类和Default类的短小请求，线程少但总有空闲；
+    // 批量类（数据库查询、导出、上传）最多占满自己的线程。线程不过期，每个线程的数据库连接得以复用
+    m_interactivePool.setMaxThreadCount(2);
+    m_interactivePool.setExpiryTimeout(-1);
+    m_bulkPool.setMaxThreadCount(4);
+    m_bulkPool.setExpiryTimeout(-1);
+    // 流式导出超过线程数时在本线程池排队，等待前面的下载结束
+    m_streamPool.setMaxThreadCount(2);
+    m_streamPool.setExpiryTimeout(-1);
+
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const QPair<const char*, QThreadPool*> pools[] = {
+        {"interactive", &m_interactivePool},
+        {"bulk", &m_bulkPool},
+        {"stream", &m_streamPool},
+    };
+    for (const auto& entry : pools) {
+        QThreadPool* pool = entry.second;
+        const QByteArray labels = MetricsRegistry::label("pool", entry.first);
+        m_metricCallbacks.push_back(registry.gaugeCallback(
+            "http_pool_active_threads", "Pool threads running work", labels,
+            [pool]() { return static_cast<double>(pool->activeThreadCount()); }));
+        m_metricCallbacks.push_back(registry.gaugeCallback(
+            "http_pool_max_threads", "Thread budget of the pool", labels,
+            [pool]() { return static_cast<double>(pool->maxThreadCount()); }));
+    }
+
+    m_routeNodes.push_back(std::make_unique<RouteNode>());
+    m_routeRoot = m_routeNodes.back().get();
+    m_unmatchedMetrics = createRouteMetrics(QString(), "unmatched");
+
+    // CORS头部由HttpResponseWriter以预渲染的固定头部统一输出，这里只处理预检请求
+    // 增加CORS支持的OPTIONS请求处理：任何路径的预检请求都直接应答
+    addMiddleware([](const HttpRequest& req, const NextHandler& next) {
+        if (req.method != "OPTIONS") {
+            return next(req);
+        }
+        HttpResponse response;
+        response.statusCode = 200;
+        response.statusMessage = "OK";
+        response.contentType = "text/plain";
+        response.content = "";
+        response.headers.insert("Access-Control-Max-Age", "86400"); // 24小时
+        return response;
+    });
+
+    // 数据API路由
+    addRoute("POST", "/api/execute-sql", [this](const HttpRequest& req, const PathParams&){ return handleExecuteSQL(req); });
+    addRoute("GET", "/api/data", [this](const HttpRequest& req, const PathParams&){ return handleGetData(req); });
+    addRoute("POST", "/api/data", [this](const HttpRequest& req, const PathParams&){ return handlePostData(req); });
+    addRoute("GET", "/api/data/export", [this](const HttpRequest& req, const PathParams&){ return handleExportData(req); });
+
+    // 导航相关API路由
+    addRoute("GET", "/api/navigation/data", [this](const HttpRequest& req, const PathParams&){ return handleGetNavigationData(req); });
+    addRoute("POST", "/api/navigation", [this](const HttpRequest& req, const PathParams&){ return handlePostNavigationData(req); });
+    addRoute("GET", "/api/navigation/register", [this](const HttpRequest& req, const PathParams&){ return handleRegisterNavigation(req); });
+    addRoute("GET", "/api/navigation/unregister", [this](const HttpRequest& req, const PathParams&){ return handleUnregisterNavigation(req); });
+
+    // 页面控制路由
+    addRoute("GET", "/api/page/switch", [this](const HttpRequest& req, const PathParams&){ return handleSwitchPage(req); });
+    addRoute("GET", "/api/page/back", [this](const HttpRequest& req, const PathParams&){ return handleBackToMain(req); });
+
+    // PDF相关路由
+    addRoute("POST", "/api/pdf/upload", [this](const HttpRequest& req, const PathParams&){ return handleUploadPDF(req); });
+    addRoute("GET", "/api/pdf/control", [this](const HttpRequest& req, const PathParams&){ return handlePDFControl(req); });
+
+    // 请求体限制：不符合的请求在请求体传输之前即被拒绝
+    BodyPolicy pdfPolicy;
+    pdfPolicy.maxBodySize = 64LL * 1024 * 1024;
+    pdfPolicy.contentTypes = QStringList() << "multipart/form-data" << "application/pdf" << "application/octet-stream";
+    pdfPolicy.streamToFile = true;
+    pdfPolicy.magic = "%PDF";
+    setBodyPolicy("POST", "/api/pdf/upload", pdfPolicy);
+
+    BodyPolicy jsonPolicy;
+    jsonPolicy.maxBodySize = 1024 * 1024;
+    for (const char* pattern : {"/api/execute-sql", "/api/data", "/api/navigation", "/api/trace/sampling"}) {
+        setBodyPolicy("POST", pattern, jsonPolicy);
+    }
+
+    // 路由类别：批量类（数据库读写、导出和上传）在批量线程池执行并使用较紧的准入配额；
+    // 控制类（页面切换、PDF翻页、导航）使用独立配额，批量请求再多也不会挤占。其余路由为Default
+    const QPair<const char*, const char*> bulkRoutes[] = {
+        {"POST", "/api/execute-sql"},
+        {"GET", "/api/data"},
+        {"POST", "/api/data"},
+        {"GET", "/api/data/export"},
+        {"POST", "/api/pdf/upload"},
+    };
+    for (const auto& route : bulkRoutes) {
+        setRouteClass(route.first, route.second, HttpAdmissionController::RouteClass::Bulk);
+    }
+    const QPair<const char*, const char*> controlRoutes[] = {
+        {"GET", "/api/page/switch"},
+        {"GET", "/api/page/back"},
+        {"GET", "/api/pdf/control"},
+        {"POST", "/api/navigation"},
+        {"GET", "/api/navigation/data"},
+    };
+    for (const auto& route : controlRoutes) {
+        setRouteClass(route.first, route.second, HttpAdmissionController::RouteClass::Control);
+    }
+
+    // 截图等媒体文件（支持Range和条件请求）
+    addRoute("GET", "/api/media/{path*}", [this](const HttpRequest& req, const PathParams& params){ return handleGetMedia(req, params); });
+
+    // 运行指标（Prometheus文本格式）
+    addRoute("GET", "/metrics", [this](const HttpRequest& req, const PathParams&){ return handleMetrics(req); });
+
+    // 请求追踪：导出采样到的阶段耗时（Chrome trace-event JSON），调整采样率
+    addRoute("GET", "/api/trace", [this](const HttpRequest& req, const PathParams&){ return handleGetTrace(req); });
+    addRoute("POST", "/api/trace/sampling", [this](const HttpRequest& req, const PathParams&){ return handleSetTraceSampling(req); });
+
+    // 状态事件流：由下面的信号驱动，客户端无需轮询
+    addRoute("GET", "/api/events", [this](const HttpRequest& req, const PathParams&){ return handleEventStream(req); });
+
+    // 信号在处理请求的工作线程上发出，广播器是线程安全的，直接调用即可
+    connect(this, &RequestHandler::navigationDataReceived,
+            &m_eventBroadcaster, &EventBroadcaster::publishNavigation, Qt::DirectConnection);
+    connect(this, &RequestHandler::switchPageRequested,
+            &m_eventBroadcaster, &EventBroadcaster::publishPageSwitch, Qt::DirectConnection);
+    connect(this, &RequestHandler::backToMainRequested,
+            &m_eventBroadcaster, &EventBroadcaster::publishBackToMain, Qt::DirectConnection);
+    connect(this, &RequestHandler::pdfNextPage,
+            &m_eventBroadcaster, &EventBroadcaster::publishPdfNextPage, Qt::DirectConnection);
+    connect(this, &RequestHandler::pdfPrevPage,
+            &m_eventBroadcaster, &EventBroadcaster::publishPdfPrevPage, Qt::DirectConnection);
+}
+
+void RequestHandler::addRoute(const QString& method, const QString& pattern, RouteHandler handler)
+{
+    const QString upperMethod = method.toUpper();
+    const int routeIndex = static_cast<int>(m_routes.size());
+    m_routes.push_back({upperMethod, pattern, std::move(handler), createRouteMetrics(upperMethod, pattern)});
+
+    // 把模式按路径段插入路由树
+    const QStringList segments = pattern.split('/', Qt::SkipEmptyParts);
+    bool hasParams = false;
+    RouteNode* node = m_routeRoot;
+    for (const QString& segment : segments) {
+        if (segment.startsWith('{') && segment.endsWith('}')) {
+            hasParams = true;
+            QString name = segment.mid(1, segment.size() - 2);
+            bool catchAll = name.endsWith('*');
+            if (catchAll) {
+                name.chop(1);
+            }
+            if (!node->paramChild) {
+                m_routeNodes.push_back(std::make_unique<RouteNode>());
+                node->paramChild = m_routeNodes.back().get();
+                node->paramChild->paramName = name;
+                node->paramChild->catchAll = catchAll;
+            } else if (node->paramChild->paramName != name || node->paramChild->catchAll != catchAll) {
+                qWarning() << "路由参数与已注册的路由冲突:" << pattern;
             }
-        )
-    );
-
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/page/switch/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleSwitchPage(req); }
-        )
-    );
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/page/back/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleBackToMain(req); }
-        )
-    );
-
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^POST /api/pdf/upload/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handleUploadPDF(req); }
-        )
-    );
-    
-    m_routes.insert(
-        std::make_pair(
-            QRegularExpression("^GET /api/pdf/control/?$", QRegularExpression::CaseInsensitiveOption),
-            [this](const HttpRequest& req){ return handlePDFControl(req); }
-        )
-    );
+            node = node->paramChild;
+        } else {
+            RouteNode*& child = node->children[segment];
+            if (!child) {
+                m_routeNodes.push_back(std::make_unique<RouteNode>());
+                child = m_routeNodes.back().get();
+            }
+            node = child;
+        }
+    }
+
+    if (node->routes.contains(upperMethod)) {
+        qWarning() << "重复注册路由:" << upperMethod << pattern;
+    }
+    node->routes.insert(upperMethod, routeIndex);
+
+    // 不含参数的路由额外登记到静态表，匹配时一次哈希查找即可命中
+    if (!hasParams) {
+        m_staticRoutes[upperMethod].insert("/" + segments.join('/'), routeIndex);
+    }
+}
+
+void RequestHandler::addMiddleware(Middleware middleware)
+{
+    m_middlewares.push_back(std::move(middleware));
+}
+
+int RequestHandler::matchNode(const RouteNode* node, const QList<QStringView>& segments, int index,
+                              const QString& method, PathParams& params) const
+{
+    if (index == segments.size()) {
+        return node->routes.value(method, -1);
+    }
+
+    const QStringView segment = segments[index];
+
+    // 静态路径段优先
+    auto it = node->children.constFind(segment.toString());
+    if (it != node->children.constEnd()) {
+        int routeIndex = matchNode(it.value(), segments, index + 1, method, params);
+        if (routeIndex >= 0) {
+            return routeIndex;
+        }
+    }
+
+    const RouteNode* child = node->paramChild;
+    if (!child) {
+        return -1;
+    }
+
+    if (child->catchAll) {
+        int routeIndex = child->routes.value(method, -1);
+        if (routeIndex >= 0) {
+            QString rest;
+            for (int i = index; i < segments.size(); ++i) {
+                if (i > index) {
+                    rest += '/';
+                }
+                rest += segments[i];
+            }
+            params.insert(child->paramName, QUrl::fromPercentEncoding(rest.toUtf8()));
+        }
+        return routeIndex;
+    }
+
+    int routeIndex = matchNode(child, segments, index + 1, method, params);
+    if (routeIndex >= 0) {
+        params.insert(child->paramName, QUrl::fromPercentEncoding(segment.toUtf8()));
+    }
+    return routeIndex;
+}
+
+int RequestHandler::matchRoute(const QString& method, const QString& path, PathParams& params) const
+{
+    // 忽略末尾的斜杠
+    QString normalizedPath = path;
+    while (normalizedPath.size() > 1 && normalizedPath.endsWith('/')) {
+        normalizedPath.chop(1);
+    }
+
+    auto methodIt = m_staticRoutes.constFind(method);
+    if (methodIt != m_staticRoutes.constEnd()) {
+        auto routeIt = methodIt->constFind(normalizedPath);
+        if (routeIt != methodIt->constEnd()) {
+            return routeIt.value();
+        }
+    }
+
+    // 含参数的路由按路径段逐级查找，耗时只与路径深度有关
+    const QList<QStringView> segments = QStringView(normalizedPath).split(u'/', Qt::SkipEmptyParts);
+    return matchNode(m_routeRoot, segments, 0, method, params);
+}
+
+RequestHandler::HttpResponse RequestHandler::runMiddlewares(size_t index, const HttpRequest& request,
+                                                            const PathParams& params,
+                                                            const RouteHandler& handler) const
+{
+    if (index >= m_middlewares.size()) {
+        return handler(request, params);
+    }
+    return m_middlewares[index](request, [this, index, &params, &handler](const HttpRequest& req) {
+        return runMiddlewares(index + 1, req, params, handler);
+    });
+}
+
+void RequestHandler::setBodyPolicy(const QString& method, const QString& pattern, const BodyPolicy& policy)
+{
+    const QString upperMethod = method.toUpper();
+    for (Route& route : m_routes) {
+        if (route.method == upperMethod && route.pattern == pattern) {
+            route.bodyPolicy = policy;
+            return;
+        }
+    }
+    qWarning() << "设置请求体限制失败，路由未注册:" << upperMethod << pattern;
+}
+
+void RequestHandler::setRouteClass(const QString& method, const QString& pattern,
+                                   HttpAdmissionController::RouteClass routeClass)
+{
+    const QString upperMethod = method.toUpper();
+    for (Route& route : m_routes) {
+        if (route.method == upperMethod && route.pattern == pattern) {
+            route.routeClass = routeClass;
+            return;
+        }
+    }
+    qWarning() << "设置路由类别失败，路由未注册:" << upperMethod << pattern;
+}
+
+bool RequestHandler::precheckRequest(const HttpRequest& request, qint64 declaredBodySize, BodyPolicy& policy,
+                                     HttpAdmissionController::RouteClass& routeClass, HttpResponse& rejection)
+{
+    PathParams params;
+    int routeIndex;
+    {
+        RequestTracer::Span span(request.trace, "route.match");
+        routeIndex = matchRoute(request.method, request.path, params);
+    }
+    if (routeIndex < 0) {
+        policy = BodyPolicy();
+        routeClass = HttpAdmissionController::RouteClass::Default;
+        return true;
+    }
+    policy = m_routes[routeIndex].bodyPolicy;
+    routeClass = m_routes[routeIndex].routeClass;
+
+    if (policy.maxBodySize >= 0 && declaredBodySize > policy.maxBodySize) {
+        qWarning() << "请求体超过路由上限，拒绝:" << request.path << declaredBodySize << ">" << policy.maxBodySize;
+        rejection = createErrorResponse(413, "Payload Too Large");
+        return false;
+    }
+
+    // 没有请求体时不检查类型，由处理函数返回具体错误
+    if (!policy.contentTypes.isEmpty() && declaredBodySize != 0) {
+        const QString contentType = QString::fromLatin1(request.headers.value(HttpHeaders::ContentType))
+                                        .section(';', 0, 0).trimmed();
+        if (!policy.contentTypes.contains(contentType, Qt::CaseInsensitive)) {
+            qWarning() << "请求体类型不被接受，拒绝:" << request.path << contentType;
+            rejection = createErrorResponse(415, "Unsupported Media Type");
+            return false;
+        }
+    }
+    return true;
 }
 
 // 实现PDF上传处理方法
 RequestHandler::HttpResponse RequestHandler::handleUploadPDF(const HttpRequest& request)
 {
-    qDebug() << "处理PDF上传请求，内容长度:" << request.body.size();
-    
-    // 打印所有头部
-    qDebug() << "请求头:";
-    for (auto it = request.headers.constBegin(); it != request.headers.constEnd(); ++it) {
-        qDebug() << "  \"" << it.key() << "\" : \"" << it.value() << "\"";
+    std::shared_ptr<QTemporaryFile> pdfFile = request.uploadedFile;
+
+    // 兼容未经流式接收的请求体：写入临时文件后按同样方式处理
+    if (!pdfFile && !request.body.isEmpty()) {
+        pdfFile = std::make_shared<QTemporaryFile>(QDir::tempPath() + "/ar_upload_XXXXXX.pdf");
+        if (!pdfFile->open() || pdfFile->write(request.body) != request.body.size()) {
+            return createErrorResponse(500, "Failed to store PDF data");
+        }
+        pdfFile->flush();
     }
-    
+
+    // 检查请求体
+    if (!pdfFile || pdfFile->size() == 0) {
+        qWarning() << "请求体为空! Content-Type: " << request.headers.text(HttpHeaders::ContentType);
+        return createErrorResponse(400, "PDF data is empty");
+    }
+
+    qDebug() << "处理PDF上传请求，文件:" << pdfFile->fileName() << "大小:" << pdfFile->size();
+
+    // 在当前线程（批量线程池）打开并检查文档，无效文件直接拒绝，不会到达界面线程
+    QString error;
+    std::shared_ptr<UploadedPdf> pdf;
+    {
+        RequestTracer::Span span("pdf.inspect");
+        pdf = UploadedPdf::open(pdfFile, error);
+    }
+    if (!pdf) {
+        return createErrorResponse(422, error);
+    }
+
+    // 打开好的文档交给PDFViewerPage直接显示
+    emit pdfDocumentReceived(pdf);
+
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
     response.contentType = "application/json; charset=utf-8";
-    
-    // 检查请求体
-    if (request.body.isEmpty()) {
-        qWarning() << "请求体为空! Content-Type: " << request.headers.value("content-type");
-        return createErrorResponse(400, "PDF data is empty");
-    }
-    
-    // 检查PDF文件头
-    if (request.body.left(4) == QByteArray("%PDF")) {
-        qDebug() << "检测到有效的PDF文件头,大小:" << request.body.size() << "字节";
-    } else {
-        qDebug() << "数据不是有效的PDF格式,前20字节:" << request.body.left(20).toHex();
+
+    // 页面尺寸单位为点（1/72英寸）
+    QJsonArray pageSizes;
+    for (const QSizeF& size : pdf->pageSizes()) {
+        pageSizes.append(QJsonArray{qRound(size.width() * 100) / 100.0, qRound(size.height() * 100) / 100.0});
     }
-    
-    // 发出信号通知PDFViewerPage接收PDF数据
-    emit pdfDataReceived(request.body);
-    
-    // 创建成功响应
+
     QJsonObject resultObj;
     resultObj["success"] = true;
     resultObj["message"] = "PDF uploaded successfully";
-    resultObj["size"] = request.body.size();
-    resultObj["totalPages"] = 1; // 这里可以添加实际页数检测
-    
+    resultObj["size"] = pdf->fileSize();
+    resultObj["totalPages"] = pdf->pageCount();
+    resultObj["pageSizes"] = pageSizes;
+    resultObj["title"] = pdf->title();
+    resultObj["encrypted"] = pdf->encrypted();
+    resultObj["xrefRepaired"] = pdf->xrefDamaged();
+
+    RequestTracer::Span span("json.serialize");
     QJsonDocument doc(resultObj);
     response.content = doc.toJson(QJsonDocument::Compact);
-    
+
     return response;
 }
 
 // 实现PDF控制处理方法
 RequestHandler::HttpResponse RequestHandler::handlePDFControl(const HttpRequest& request)
 {
-    qDebug() << "处理PDF控制请求";
-    
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
@@ -191,8 +447,6 @@ RequestHandler::HttpResponse RequestHandler::handlePDFControl(const HttpRequest&
 // 添加对应的处理方法
 RequestHandler::HttpResponse RequestHandler::handleExecuteSQL(const HttpRequest& request)
 {
-    qDebug() << "处理POST /api/execute-sql请求";
-    
     // 解析请求体中的JSON数据
     QJsonDocument doc = QJsonDocument::fromJson(request.body);
     if (doc.isNull() || !doc.isObject()) {
@@ -214,27 +468,46 @@ RequestHandler::HttpResponse RequestHandler::handleExecuteSQL(const HttpRequest&
         (sqlLower.contains("delete") && !sqlLower.contains("where"))) {
         return createErrorResponse(403, "Potentially dangerous SQL operation not allowed");
     }
-    
-    // 执行SQL查询
-    QJsonArray result;
-    try {
-        result = m_dbWorker->queryData(sql);
-    } catch (std::exception& e) {
-        qCritical() << "数据库查询失败:" << e.what();
-        return createErrorResponse(500, "Database query failed");
+
+    // "stream": true 以chunked JSON数组返回，"stream": "ndjson" 以NDJSON返回；
+    // 结果集边读边发，大结果不必先整体放入内存。只对查询语句有效
+    QJsonValue streamValue = dataObj.value("stream");
+    bool ndjson = streamValue.toString().compare("ndjson", Qt::CaseInsensitive) == 0;
+    if ((streamValue.toBool() || ndjson) && sqlLower.trimmed().startsWith("select")) {
+        return createStreamingQueryResponse(sql, ndjson);
     }
     
-    // 构建响应
-    HttpResponse response;
-    response.statusCode = 200;
-    response.statusMessage = "OK";
-    response.contentType = "application/json; charset=utf-8";
-    
-    // 将结果转换为JSON
-    QJsonDocument resultDoc(result);
-    response.content = resultDoc.toJson(QJsonDocument::Compact);
-    
-    return response;
+    // 查询在后台线程池执行，不阻塞连接所在的事件循环
+    return deferResponse([this, sql, sqlLower]() {
+        // 执行SQL查询
+        QJsonArray result;
+        try {
+            result = m_dbWorker->queryData(sql);
+        } catch (std::exception& e) {
+            qCritical() << "数据库查询失败:" << e.what();
+            return createErrorResponse(500, "Database query failed");
+        }
+
+        // 非只读语句可能修改了数据
+        QString statement = sqlLower.trimmed();
+        if (!statement.startsWith("select") && !statement.startsWith("show")
+            && !statement.startsWith("describe") && !statement.startsWith("explain")) {
+            invalidateDataVersion();
+        }
+
+        // 构建响应
+        HttpResponse response;
+        response.statusCode = 200;
+        response.statusMessage = "OK";
+        response.contentType = "application/json; charset=utf-8";
+
+        // 将结果转换为JSON
+        RequestTracer::Span span("json.serialize");
+        QJsonDocument resultDoc(result);
+        response.content = resultDoc.toJson(QJsonDocument::Compact);
+
+        return response;
+    });
 }
 
 void RequestHandler::registerNavigationWidget(NavigationDisplayWidget* widget)
@@ -252,88 +525,327 @@ void RequestHandler::registerNavigationWidget(NavigationDisplayWidget* widget)
 
 void RequestHandler::unregisterNavigationWidget()
 {
+    QMutexLocker locker(&m_mutex);
     m_navigationWidget = nullptr;
     qDebug() << "导航显示部件已注销";
 }
 
 bool RequestHandler::isNavigationWidgetActive() const
 {
+    QMutexLocker locker(&m_mutex);
     return m_navigationWidget != nullptr;
 }
 
 RequestHandler::HttpResponse RequestHandler::handleRequest(const HttpRequest& request)
 {
-    
-    qDebug() << "处理请求，路由键:" << request.path;
-    
-    // 当请求是OPTIONS时，处理CORS预检请求
-    if (request.method == "OPTIONS") {
-        HttpResponse response;
-        response.statusCode = 200;
-        response.statusMessage = "OK";
-        response.contentType = "text/plain";
-        response.content = "";
-        
-        // 添加CORS头部
-        response.headers.insert("Access-Control-Allow-Origin", "*");
-        response.headers.insert("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-        response.headers.insert("Access-Control-Allow-Headers", "Content-Type");
-        
+    QElapsedTimer timer;
+    timer.start();
+
+    PathParams params;
+    int routeIndex = matchRoute(request.method, request.path, params);
+    if (routeIndex < 0) {
+        // 如果没有匹配的路由，返回404（中间件仍然执行，OPTIONS预检在中间件中应答）
+        HttpResponse response = runMiddlewares(0, request, params, [this](const HttpRequest&, const PathParams&) {
+            return createErrorResponse(404, "Not Found");
+        });
+        recordRouteMetrics(m_unmatchedMetrics, response.statusCode, timer.nsecsElapsed());
         return response;
     }
-    
-    // 原有的路由逻辑...
+
+    const Route& route = m_routes[routeIndex];
+
     HttpResponse response;
-    
-    // 匹配GET /api/data
-    if (request.method == "GET" && request.path == "/api/data") {
-        response = handleGetData(request);
+    {
+        RequestTracer::Span span(request.trace, "route.handler");
+        response = runMiddlewares(0, request, params, route.handler);
+    }
+    if (!response.deferred) {
+        recordRouteMetrics(route.metrics, response.statusCode, timer.nsecsElapsed());
+        return response;
+    }
+
+    // 延迟响应：在后台执行完成时再记录指标，异常转换为500
+    // 追踪上下文随任务进入线程池，数据库等阶段记到同一请求下
+    const RouteMetrics& metrics = route.metrics;
+    const RequestTracer::Context trace = request.trace;
+    const qint64 queuedNs = trace.sampled ? RequestTracer::nowNs() : 0;
+    response.deferred = [this, work = std::move(response.deferred), &metrics, timer, trace, queuedNs]() {
+        if (trace.sampled) {
+            RequestTracer::instance().record(trace, "deferred.queue", queuedNs, RequestTracer::nowNs());
+        }
+        RequestTracer::Scope scope(trace);
+        RequestTracer::Span span(trace, "deferred.run");
+
+        HttpResponse result;
+        try {
+            result = work();
+        } catch (const std::exception& e) {
+            qCritical() << "延迟处理请求时发生异常:" << e.what();
+            result = createErrorResponse(500, "Internal Server Error");
+        } catch (...) {
+            qCritical() << "延迟处理请求时发生未知异常";
+            result = createErrorResponse(500, "Internal Server Error");
+        }
+        recordRouteMetrics(metrics, result.statusCode, timer.nsecsElapsed());
+        return result;
+    };
+    return response;
+}
+
+RequestHandler::HttpResponse RequestHandler::deferResponse(std::function<HttpResponse()> work)
+{
+    HttpResponse response;
+    response.deferred = std::move(work);
+    return response;
+}
+
+RequestHandler::RouteMetrics RequestHandler::createRouteMetrics(const QString& method, const QString& route)
+{
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const QByteArray labels = MetricsRegistry::label("method", method) + ","
+                              + MetricsRegistry::label("route", route);
+
+    RouteMetrics metrics;
+    metrics.latency = registry.histogram("http_request_duration_seconds",
+                                         "Request handling time by matched route", labels);
+    for (int i = 0; i < 5; ++i) {
+        metrics.responses[i] = registry.counter("http_requests_total", "Requests by matched route and status class",
+                                                labels + ",code=\"" + QByteArray::number(i + 1) + "xx\"");
+    }
+    metrics.errors = registry.counter("http_request_errors_total",
+                                      "Requests answered with status >= 400", labels);
+    return metrics;
+}
+
+void RequestHandler::recordRouteMetrics(const RouteMetrics& metrics, int statusCode, qint64 elapsedNs)
+{
+    metrics.latency->observeNanoseconds(elapsedNs);
+    metrics.responses[qBound(1, statusCode / 100, 5) - 1]->inc();
+    if (statusCode >= 400) {
+        metrics.errors->inc();
+    }
+}
+
+namespace {
+// 媒体文件的Content-Type
+QString mediaContentType(const QString& suffix)
+{
+    static const QHash<QString, QString> types = {
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"png", "image/png"},
+        {"webp", "image/webp"},
+        {"gif", "image/gif"},
+        {"bmp", "image/bmp"},
+        {"mp4", "video/mp4"},
+        {"pdf", "application/pdf"},
+    };
+    return types.value(suffix.toLower(), "application/octet-stream");
+}
+
+// RFC 7231 HTTP-date（IMF-fixdate）
+QString httpDate(const QDateTime& time)
+{
+    return QLocale::c().toString(time.toUTC(), "ddd, dd MMM yyyy hh:mm:ss") + " GMT";
+}
+
+QDateTime parseHttpDate(const QString& value)
+{
+    QDateTime time = QLocale::c().toDateTime(value.trimmed(), "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+    time.setTimeZone(QTimeZone::UTC);
+    return time;
+}
+
+// 解析单个字节范围"bytes=a-b"、"bytes=a-"、"bytes=-n"。
+// 返回1表示得到有效范围，0表示应忽略Range（多段或格式无法识别，按完整响应处理），-1表示范围无法满足
+int parseByteRange(const QString& header, qint64 size, qint64& start, qint64& end)
+{
+    QString spec = header.trimmed();
+    if (!spec.startsWith("bytes=", Qt::CaseInsensitive)) {
+        return 0;
     }
-    // 其他路由逻辑...
-    else if (request.method == "GET" && request.path == "/api/navigation/data") {
-        response = handleGetNavigationData(request);
+    spec = spec.mid(6).trimmed();
+    if (spec.contains(',')) {
+        return 0;
     }
-    else if (request.method == "GET" && request.path == "/api/navigation/register") {
-        response = handleRegisterNavigation(request);
+    int dash = spec.indexOf('-');
+    if (dash < 0) {
+        return 0;
     }
-    else if (request.method == "GET" && request.path == "/api/page/switch") {
-        response = handleSwitchPage(request);
+
+    bool ok = false;
+    const QString first = spec.left(dash).trimmed();
+    const QString last = spec.mid(dash + 1).trimmed();
+    if (first.isEmpty()) {
+        // 后缀范围：最后n个字节
+        qint64 suffix = last.toLongLong(&ok);
+        if (!ok || suffix < 0) {
+            return 0;
+        }
+        if (suffix == 0 || size == 0) {
+            return -1;
+        }
+        start = qMax<qint64>(0, size - suffix);
+        end = size - 1;
+        return 1;
     }
-    else if (request.method == "GET" && request.path == "/api/page/back") {
-        response = handleBackToMain(request);
+
+    start = first.toLongLong(&ok);
+    if (!ok || start < 0) {
+        return 0;
     }
-    else if (request.method == "GET" && request.path == "/api/navigation/unregister") {
-        response = handleUnregisterNavigation(request);
+    if (last.isEmpty()) {
+        end = size - 1;
+    } else {
+        end = last.toLongLong(&ok);
+        if (!ok || end < start) {
+            return 0;
+        }
+        end = qMin(end, size - 1);
     }
-    else if (request.method == "POST" && request.path == "/api/navigation") {
-        response = handlePostNavigationData(request);
+    return start < size ? 1 : -1;
+}
+}
+
+RequestHandler::HttpResponse RequestHandler::handleGetMedia(const HttpRequest& request, const PathParams& params)
+{
+    const QString relativePath = params.value("path");
+
+    // 唯一的路径安全检查：根目录和文件都规范化（解析..和符号链接）后，文件必须位于根目录之内。
+    // 根目录每次请求时规范化，目录在服务器启动之后才创建、或上级目录是符号链接时同样适用
+    const QString canonicalRoot = QFileInfo(m_mediaRoot).canonicalFilePath();
+    QFileInfo info(m_mediaRoot + "/" + relativePath);
+    const QString canonicalPath = info.canonicalFilePath();
+    if (relativePath.isEmpty() || canonicalRoot.isEmpty() || canonicalPath.isEmpty() || !info.isFile()
+        || !canonicalPath.startsWith(canonicalRoot + "/")) {
+        return createErrorResponse(404, "Not Found");
     }
-    else if (request.method == "POST" && request.path == "/api/pdf/upload") {
-        response = handleUploadPDF(request);
+
+    const qint64 size = info.size();
+    const QDateTime modified = info.lastModified().toUTC();
+    const QString lastModified = httpDate(modified);
+    const QString etag = QString("\"m-%1-%2\"").arg(QString::number(size, 36),
+                                                    QString::number(modified.toSecsSinceEpoch(), 36));
+
+    // 截图文件写入后不再修改，客户端可以直接使用缓存，过期后再按条件请求验证
+    auto addCacheHeaders = [&](HttpResponse& response) {
+        response.headers.insert("ETag", etag);
+        response.headers.insert("Last-Modified", lastModified);
+        response.headers.insert("Cache-Control", "private, max-age=86400");
+        response.headers.insert("Accept-Ranges", "bytes");
+    };
+
+    // If-None-Match优先于If-Modified-Since
+    const QString ifModifiedSince = request.headers.text(HttpHeaders::IfModifiedSince);
+    bool notModified = false;
+    if (!request.headers.value(HttpHeaders::IfNoneMatch).isEmpty()) {
+        notModified = etagMatches(request, etag);
+    } else if (!ifModifiedSince.isEmpty()) {
+        QDateTime since = parseHttpDate(ifModifiedSince);
+        notModified = since.isValid() && modified.toSecsSinceEpoch() <= since.toSecsSinceEpoch();
     }
-    else if (request.method == "POST" && request.path == "/api/execute-sql") {
-        response = handleExecuteSQL(request);
+    if (notModified) {
+        HttpResponse response;
+        response.statusCode = 304;
+        response.statusMessage = "Not Modified";
+        addCacheHeaders(response);
+        return response;
     }
-    else if (request.method == "GET" && request.path == "/api/pdf/control") {
-        response = handlePDFControl(request);
+
+    auto file = std::make_shared<QFile>(canonicalPath);
+    if (!file->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        qWarning() << "无法打开媒体文件:" << canonicalPath << file->errorString();
+        return createErrorResponse(404, "Not Found");
     }
-    else {
-        // 如果没有匹配的路由，返回404
-        response = createErrorResponse(404, "Not Found");
+
+    HttpResponse response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.contentType = mediaContentType(info.suffix());
+    addCacheHeaders(response);
+    response.file = file;
+    response.fileOffset = 0;
+    response.fileLength = size;
+
+    // If-Range与当前版本不符时忽略Range，返回完整文件
+    const QString range = request.headers.text(HttpHeaders::Range);
+    const QString ifRange = request.headers.text(HttpHeaders::IfRange).trimmed();
+    if (range.isEmpty() || (!ifRange.isEmpty() && ifRange != etag && ifRange != lastModified)) {
+        return response;
     }
-    
-    // 为所有响应添加CORS头部
-    response.headers.insert("Access-Control-Allow-Origin", "*");
-    response.headers.insert("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-    response.headers.insert("Access-Control-Allow-Headers", "Content-Type");
-    
+
+    qint64 start = 0;
+    qint64 end = 0;
+    int rangeResult = parseByteRange(range, size, start, end);
+    if (rangeResult < 0) {
+        HttpResponse unsatisfiable = createErrorResponse(416, "Range Not Satisfiable");
+        unsatisfiable.headers.insert("Content-Range", QString("bytes */%1").arg(size));
+        return unsatisfiable;
+    }
+    if (rangeResult > 0) {
+        response.statusCode = 206;
+        response.statusMessage = "Partial Content";
+        response.headers.insert("Content-Range", QString("bytes %1-%2/%3").arg(start).arg(end).arg(size));
+        response.fileOffset = start;
+        response.fileLength = end - start + 1;
+    }
+    return response;
+}
+
+RequestHandler::HttpResponse RequestHandler::handleMetrics(const HttpRequest& request)
+{
+    Q_UNUSED(request);
+
+    HttpResponse response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.contentType = "text/plain; version=0.0.4; charset=utf-8";
+    response.content = MetricsRegistry::instance().render();
+    return response;
+}
+
+RequestHandler::HttpResponse RequestHandler::handleGetTrace(const HttpRequest& request)
+{
+    // ?clear=1 导出后清空，便于按时间段分别采集
+    bool clear = request.query.value("clear") == "1";
+
+    HttpResponse response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.contentType = "application/json; charset=utf-8";
+    response.headers.insert("Cache-Control", "no-store");
+    response.content = RequestTracer::instance().exportChromeTrace(clear);
+    return response;
+}
+
+RequestHandler::HttpResponse RequestHandler::handleSetTraceSampling(const HttpRequest& request)
+{
+    // 请求体：{"rate": 0~1}，0表示关闭追踪
+    QJsonDocument doc = QJsonDocument::fromJson(request.body);
+    if (!doc.isObject() || !doc.object().value("rate").isDouble()) {
+        return createErrorResponse(400, "Missing numeric rate");
+    }
+
+    RequestTracer& tracer = RequestTracer::instance();
+    tracer.setSampleRate(doc.object().value("rate").toDouble());
+    qInfo() << "请求追踪采样率已设置为:" << tracer.sampleRate();
+
+    QJsonObject resultObj;
+    resultObj["success"] = true;
+    resultObj["sampleRate"] = tracer.sampleRate();
+
+    HttpResponse response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.contentType = "application/json; charset=utf-8";
+    response.content = QJsonDocument(resultObj).toJson(QJsonDocument::Compact);
     return response;
 }
 
 // 处理导航注册请求
 RequestHandler::HttpResponse RequestHandler::handleRegisterNavigation(const HttpRequest& request)
 {
-    qDebug() << "处理导航注册请求，来自:" << request.headers.value("User-Agent", "未知");
+    qDebug() << "处理导航注册请求，来自:" << request.headers.text(HttpHeaders::UserAgent, "未知");
     
     HttpResponse response;
     response.statusCode = 200;
@@ -347,7 +859,7 @@ RequestHandler::HttpResponse RequestHandler::handleRegisterNavigation(const Http
     QMutexLocker locker(&m_mutex);
     
     if (m_navigationWidget) {
-        m_navigationActive = true;
+        m_navigationState.setActive(true);
         
         resultObj["success"] = true;
         resultObj["message"] = "Navigation registered successfully";
@@ -387,12 +899,12 @@ RequestHandler::HttpResponse RequestHandler::handleUnregisterNavigation(const Ht
     
     QJsonObject resultObj;
     
+    QMutexLocker locker(&m_mutex);
+    
     // 检查是否已注册导航部件
     if (m_navigationWidget) {
         QString deviceID = request.query.contains("deviceID") ? request.query["deviceID"] : "";
         
-        QMutexLocker locker(&m_mutex);
-        
         // 假设NavigationDisplayWidget有unregisterDevice方法
         // 如果没有这个方法，需要修改或移除这行
         // m_navigationWidget->unregisterDevice(deviceID);
@@ -413,8 +925,6 @@ RequestHandler::HttpResponse RequestHandler::handleUnregisterNavigation(const Ht
 // 处理POST导航请求
 RequestHandler::HttpResponse RequestHandler::handlePostNavigationData(const HttpRequest& request)
 {
-    qDebug() << "处理导航数据提交请求，线程ID:" << QThread::currentThreadId() << "请求体:" << request.body;
-    
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
@@ -432,8 +942,6 @@ RequestHandler::HttpResponse RequestHandler::handlePostNavigationData(const Http
     QJsonObject navData = doc.object();
     QString action = navData["action"].toString();
     
-    qDebug() << "导航动作:" << action;
-    
     if (action == "update_navigation") {
         if (!navData.contains("direction") || !navData.contains("distance")) {
             qWarning() << "缺少方向或距离字段";
@@ -443,25 +951,11 @@ RequestHandler::HttpResponse RequestHandler::handlePostNavigationData(const Http
         QString direction = navData["direction"].toString();
         QString distance = navData["distance"].toString();
         
-        qDebug() << "更新导航 - 方向:" << direction << "距离:" << distance;
-        
+        // 显示部件订阅了状态对象，连续的更新在GUI线程合并为一次刷新
+        m_navigationState.update(direction, distance);
+
         QMutexLocker locker(&m_mutex);
-        m_currentDirection = direction;
-        m_currentDistance = distance;
-        m_navigationActive = true;
-        
-        // 使用NavigationDisplayWidget的updateNavigation方法
         if (m_navigationWidget) {
-            qDebug() << "调用NavigationDisplayWidget.updateNavigation - widget地址:" << m_navigationWidget;
-            
-            // 使用直接连接而非QueuedConnection
-            bool success = QMetaObject::invokeMethod(m_navigationWidget, "updateNavigation", 
-                                      Qt::DirectConnection,
-                                      Q_ARG(QString, direction),
-                                      Q_ARG(QString, distance));
-            
-            qDebug() << "QMetaObject::invokeMethod 结果:" << (success ? "成功" : "失败");
-            
             // 在更新导航数据后添加信号
             emit navigationDataReceived(direction, distance);
             
@@ -474,19 +968,13 @@ RequestHandler::HttpResponse RequestHandler::handlePostNavigationData(const Http
         }
     } 
     else if (action == "stop_navigation") {
+        m_navigationState.stop();
+
         QMutexLocker locker(&m_mutex);
-        m_navigationActive = false;
-        m_currentDirection = "未设置";
-        m_currentDistance = "未知";
-        
         if (m_navigationWidget) {
-            QMetaObject::invokeMethod(m_navigationWidget, "updateNavigation", 
-                                    Qt::DirectConnection,
-                                    Q_ARG(QString, m_currentDirection),
-                                    Q_ARG(QString, m_currentDistance));
-            
             // 同样在stop_navigation添加
-            emit navigationDataReceived(m_currentDirection, m_currentDistance);
+            const NavigationState state = m_navigationState.snapshot();
+            emit navigationDataReceived(state.direction, state.distance);
         }
         
         resultObj["success"] = true;
@@ -508,26 +996,35 @@ RequestHandler::HttpResponse RequestHandler::handlePostNavigationData(const Http
 // 处理GET导航数据请求
 RequestHandler::HttpResponse RequestHandler::handleGetNavigationData(const HttpRequest& request)
 {
-    qDebug() << "处理GET导航数据请求";
-    
+    // 一次取得一致的快照；部件是否注册同样影响响应内容，体现在ETag的类别中
+    const NavigationState state = m_navigationState.snapshot();
+    QMutexLocker locker(&m_mutex);
+    const bool widgetAvailable = m_navigationWidget != nullptr;
+    locker.unlock();
+
+    // 状态未变化时直接回复304
+    QString etag = makeETag(widgetAvailable ? "n" : "nx", state.version);
+    if (etagMatches(request, etag)) {
+        return createNotModifiedResponse(etag);
+    }
+
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
     response.contentType = "application/json; charset=utf-8";
+    response.headers.insert("ETag", etag);
+    response.headers.insert("Cache-Control", "no-cache");
     
     QJsonObject resultObj;
     
-    // 使用互斥锁保护共享资源
-    QMutexLocker locker(&m_mutex);
-    
     // 检查是否已注册导航部件
-    if (m_navigationWidget) {
+    if (widgetAvailable) {
         // 获取当前导航数据
         QJsonObject navData;
-        navData["direction"] = m_currentDirection;
-        navData["distance"] = m_currentDistance;
-        navData["active"] = m_navigationActive;
-        navData["timestamp"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
+        navData["direction"] = state.direction;
+        navData["distance"] = state.distance;
+        navData["active"] = state.active;
+        navData["timestamp"] = state.updatedAt.toString("yyyy-MM-dd hh:mm:ss.zzz");
         resultObj = navData;
     } else {
         resultObj["error"] = true;
@@ -547,37 +1044,108 @@ RequestHandler::HttpResponse RequestHandler::handleGetNavigationData(const HttpR
 
 RequestHandler::HttpResponse RequestHandler::handleGetData(const HttpRequest& request)
 {
-    qDebug() << "处理GET /api/data请求";
-    
-    // 使用数据库工作器执行查询，获取translations表中的所有数据
-    QJsonArray data;
-    try {
-        // 需要修改这里的SQL查询
-        data = m_dbWorker->queryData("SELECT id, recognized_text, translated_text, timestamp AS translation_time FROM translations ORDER BY id DESC LIMIT 100");
-    } catch (std::exception& e) {
-        qCritical() << "数据库查询失败:" << e.what();
-        return createErrorResponse(500, "Database query failed");
+    // 先读取版本号再查询：查询期间若有写入，返回的ETag偏旧，下次请求会重新获取
+    QString etag = makeETag("d", m_dataVersion.load(std::memory_order_acquire));
+    if (etagMatches(request, etag)) {
+        // 数据未变化，无需访问数据库
+        return createNotModifiedResponse(etag);
     }
     
-    // 构建响应
+    return deferResponse([this, etag]() {
+        // 使用数据库工作器执行查询，获取translations表中的所有数据
+        QJsonArray data;
+        try {
+            // 需要修改这里的SQL查询
+            data = m_dbWorker->queryData("SELECT id, recognized_text, translated_text, timestamp AS translation_time FROM translations ORDER BY id DESC LIMIT 100");
+        } catch (std::exception& e) {
+            qCritical() << "数据库查询失败:" << e.what();
+            return createErrorResponse(500, "Database query failed");
+        }
+
+        // 构建响应
+        HttpResponse response;
+        response.statusCode = 200;
+        response.statusMessage = "OK";
+        response.contentType = "application/json; charset=utf-8";
+        response.headers.insert("ETag", etag);
+        response.headers.insert("Cache-Control", "no-cache");
+
+        // 将结果转换为JSON
+        RequestTracer::Span span("json.serialize");
+        QJsonDocument doc(data);
+        response.content = doc.toJson(QJsonDocument::Compact);
+
+        return response;
+    });
+}
+
+RequestHandler::HttpResponse RequestHandler::handleExportData(const HttpRequest& request)
+{
+    // 导出全部翻译记录，?format=ndjson时每行一条记录
+    bool ndjson = request.query.value("format").compare("ndjson", Qt::CaseInsensitive) == 0;
+    HttpResponse response = createStreamingQueryResponse(
+        "SELECT id, recognized_text, translated_text, timestamp AS translation_time FROM translations ORDER BY id",
+        ndjson);
+    response.headers.insert("Content-Disposition",
+                            ndjson ? "attachment; filename=\"translations.ndjson\""
+                                   : "attachment; filename=\"translations.json\"");
+    return response;
+}
+
+RequestHandler::HttpResponse RequestHandler::createStreamingQueryResponse(const QString& sql, bool ndjson)
+{
+    // 每块约一批行；队列最多积压几块，连接写不动时生产方阻塞，数据库游标随之暂停
+    static const int kRowsPerChunk = 256;
+
+    auto stream = std::make_shared<HttpBodyStream>();
+    HttpBodyStream::Writer writer = stream->writer();
+
+    m_streamPool.start([this, sql, ndjson, writer, trace = RequestTracer::current()]() mutable {
+        RequestTracer::Scope scope(trace);
+        RequestTracer::Span span(trace, "stream.produce");
+
+        // 数组起始括号随第一批行发送：查询失败时尚未写出任何数据，连接还能改为回复500
+        bool first = true;
+        bool ok = false;
+        try {
+            ok = m_dbWorker->streamQuery(sql, kRowsPerChunk, [&](const QJsonArray& rows) {
+                QByteArray chunk;
+                for (const QJsonValue& row : rows) {
+                    QByteArray json = QJsonDocument(row.toObject()).toJson(QJsonDocument::Compact);
+                    if (ndjson) {
+                        chunk.append(json).append('\n');
+                    } else {
+                        chunk.append(first ? '[' : ',');
+                        chunk.append(json);
+                    }
+                    first = false;
+                }
+                return writer.write(chunk);
+            });
+        } catch (const std::exception& e) {
+            qCritical() << "流式查询失败:" << e.what();
+        }
+
+        if (!ok) {
+            writer.fail();
+            return;
+        }
+        if (!ndjson && !writer.write(first ? "[]" : "]")) {
+            return;
+        }
+        writer.finish();
+    });
+
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
-    response.contentType = "application/json; charset=utf-8";
-    
-    // 将结果转换为JSON
-    QJsonDocument doc(data);
-    response.content = doc.toJson(QJsonDocument::Compact);
-    
-    qDebug() << "查询结果大小:" << data.size() << "条记录";
-    
+    response.contentType = ndjson ? "application/x-ndjson" : "application/json; charset=utf-8";
+    response.bodyStream = stream;
     return response;
 }
 
 RequestHandler::HttpResponse RequestHandler::handlePostData(const HttpRequest& request)
 {
-    qDebug() << "处理POST /api/data请求";
-    
     // 解析请求体中的JSON数据
     QJsonDocument doc = QJsonDocument::fromJson(request.body);
     if (doc.isNull() || !doc.isObject()) {
@@ -595,33 +1163,37 @@ RequestHandler::HttpResponse RequestHandler::handlePostData(const HttpRequest& r
     QString translatedText = dataObj["translated_text"].toString();
     
     // 插入数据到数据库
-    QJsonArray result;
-    QString sql = QString("INSERT INTO translations (recognized_text, translated_text, timestamp) VALUES ('%1', '%2', NOW())")
+    // CURRENT_TIMESTAMP在MySQL和SQLite中都可用
+    QString sql = QString("INSERT INTO translations (recognized_text, translated_text, timestamp) VALUES ('%1', '%2', CURRENT_TIMESTAMP)")
                   .arg(recognizedText.replace("'", "''"))
                   .arg(translatedText.replace("'", "''"));
     
-    try {
-        result = m_dbWorker->queryData(sql);
-    } catch (std::exception& e) {
-        qCritical() << "数据库插入失败:" << e.what();
-        return createErrorResponse(500, "Database insert failed");
-    }
-    
-    // 构建响应
-    HttpResponse response;
-    response.statusCode = 201;
-    response.statusMessage = "Created";
-    response.contentType = "application/json; charset=utf-8";
-    
-    // 创建响应JSON
-    QJsonObject respObj;
-    respObj["success"] = true;
-    respObj["message"] = "Data saved successfully";
-    
-    QJsonDocument respDoc(respObj);
-    response.content = respDoc.toJson(QJsonDocument::Compact);
-    
-    return response;
+    // 插入在后台线程池执行
+    return deferResponse([this, sql]() {
+        try {
+            m_dbWorker->queryData(sql);
+        } catch (std::exception& e) {
+            qCritical() << "数据库插入失败:" << e.what();
+            return createErrorResponse(500, "Database insert failed");
+        }
+        invalidateDataVersion();
+
+        // 构建响应
+        HttpResponse response;
+        response.statusCode = 201;
+        response.statusMessage = "Created";
+        response.contentType = "application/json; charset=utf-8";
+
+        // 创建响应JSON
+        QJsonObject respObj;
+        respObj["success"] = true;
+        respObj["message"] = "Data saved successfully";
+
+        QJsonDocument respDoc(respObj);
+        response.content = respDoc.toJson(QJsonDocument::Compact);
+
+        return response;
+    });
 }
 
 RequestHandler::HttpResponse RequestHandler::createErrorResponse(int statusCode, const QString& message)
@@ -641,6 +1213,81 @@ RequestHandler::HttpResponse RequestHandler::createErrorResponse(int statusCode,
     return response;
 }
 
+void RequestHandler::setMediaRoot(const QString& directory)
+{
+    // 只记下绝对路径：目录可能尚不存在，或之后经由符号链接的上级目录创建，
+    // 规范化在每次请求时进行
+    m_mediaRoot = QFileInfo(directory).absoluteFilePath();
+}
+
+void RequestHandler::setUiStateProvider(std::function<QJsonObject()> provider)
+{
+    QMutexLocker locker(&m_mutex);
+    m_uiStateProvider = std::move(provider);
+}
+
+QJsonObject RequestHandler::uiState() const
+{
+    std::function<QJsonObject()> provider;
+    {
+        QMutexLocker locker(&m_mutex);
+        provider = m_uiStateProvider;
+    }
+    return provider ? provider() : QJsonObject();
+}
+
+void RequestHandler::invalidateDataVersion()
+{
+    m_dataVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+QString RequestHandler::makeETag(const char* kind, quint64 version) const
+{
+    return QString("\"%1-%2-%3\"").arg(QLatin1String(kind), m_etagEpoch, QString::number(version, 36));
+}
+
+bool RequestHandler::etagMatches(const HttpRequest& request, const QString& etag) const
+{
+    const QString ifNoneMatch = request.headers.text(HttpHeaders::IfNoneMatch);
+    if (ifNoneMatch.isEmpty()) {
+        return false;
+    }
+
+    // 可能是逗号分隔的列表；GET请求按弱比较，忽略W/前缀
+    const QStringList candidates = ifNoneMatch.split(',', Qt::SkipEmptyParts);
+    for (QString candidate : candidates) {
+        candidate = candidate.trimmed();
+        if (candidate == "*") {
+            return true;
+        }
+        if (candidate.startsWith("W/")) {
+            candidate = candidate.mid(2);
+        }
+        // 压缩的响应在ETag末尾加了编码后缀，所指的资源版本相同
+        for (const char* suffix : {"-gzip\"", "-deflate\""}) {
+            if (candidate.endsWith(QLatin1String(suffix))) {
+                candidate.chop(static_cast<int>(qstrlen(suffix)));
+                candidate.append('"');
+                break;
+            }
+        }
+        if (candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RequestHandler::HttpResponse RequestHandler::createNotModifiedResponse(const QString& etag) const
+{
+    HttpResponse response;
+    response.statusCode = 304;
+    response.statusMessage = "Not Modified";
+    response.headers.insert("ETag", etag);
+    response.headers.insert("Cache-Control", "no-cache");
+    return response;
+}
+
 RequestHandler::HttpResponse RequestHandler::handleError(int code, const QString& message)
 {
     HttpResponse response;
@@ -654,8 +1301,6 @@ RequestHandler::HttpResponse RequestHandler::handleError(int code, const QString
 
 RequestHandler::HttpResponse RequestHandler::handleSwitchPage(const HttpRequest& request)
 {
-    qDebug() << "处理页面切换请求";
-    
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
@@ -688,10 +1333,21 @@ RequestHandler::HttpResponse RequestHandler::handleSwitchPage(const HttpRequest&
     return response;
 }
 
+RequestHandler::HttpResponse RequestHandler::handleEventStream(const HttpRequest& request)
+{
+    qDebug() << "新的事件流客户端，User-Agent:" << request.headers.text(HttpHeaders::UserAgent, "未知");
+
+    HttpResponse response;
+    response.statusCode = 200;
+    response.statusMessage = "OK";
+    response.contentType = "text/event-stream; charset=utf-8";
+    response.headers.insert("Cache-Control", "no-cache");
+    response.eventStream = m_eventBroadcaster.subscribe();
+    return response;
+}
+
 RequestHandler::HttpResponse RequestHandler::handleBackToMain(const HttpRequest& request)
 {
-    qDebug() << "处理返回主页请求";
-    
     HttpResponse response;
     response.statusCode = 200;
     response.statusMessage = "OK";
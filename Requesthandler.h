@@ -2,24 +2,33 @@
 #define REQUESTHANDLER_H
 
 #include <QObject>
-#include <QRegularExpression>
 #include <functional>
+#include <vector>
 #include <QMap>
+#include <QHash>
 #include <QUrlQuery>
 #include <QString>
+#include <QStringList>
 #include <QByteArray>
+#include <QJsonObject>
 #include "Databaseworker.h"
+#include "EventBroadcaster.h"
+#include "NavigationStateStore.h"
+#include "HttpBodyStream.h"
+#include "Metrics.h"
+#include "RequestTracer.h"
+#include "HttpHeaders.h"
+#include "UploadedPdf.h"
+#include "HttpAdmissionController.h"
 #include <QMutex>
+#include <QTemporaryFile>
+#include <QFile>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
 // Forward declaration
 class NavigationDisplayWidget;
 
-// Custom comparator for QRegularExpression to be used in the routes map
-struct QRegularExpressionCompare {
-    bool operator()(const QRegularExpression& a, const QRegularExpression& b) const {
-        return a.pattern() < b.pattern();
-    }
-};
-
 class RequestHandler : public QObject
 {
     Q_OBJECT
@@ -27,9 +36,14 @@ public:
     struct HttpRequest {
         QString method;
         QString path;
-        QMap<QString, QString> headers;
+        // 原始头部字节及索引，查询返回视图（大小写不敏感）
+        HttpHeaders headers;
         QMap<QString, QString> query;
         QByteArray body;
+        // 以流式方式写入磁盘的上传文件（最后一个引用释放时自动删除）
+        std::shared_ptr<QTemporaryFile> uploadedFile;
+        // 请求ID及是否采样追踪，由连接在头部解析完毕时分配
+        RequestTracer::Context trace;
     };
 
     struct HttpResponse {
@@ -38,16 +52,81 @@ public:
         QMap<QString, QString> headers;
         QString contentType = "application/json";
         QByteArray content;
+        // 非空时连接切换为事件流（Server-Sent Events），持续推送订阅到的事件
+        std::shared_ptr<EventSubscriber> eventStream;
+        // 非空时为延迟响应：处理函数只做参数校验，耗时部分（如数据库查询）
+        // 由连接交给所属类别的deferredPool()执行，完成后写回原连接
+        std::function<HttpResponse()> deferred;
+        // 非空时响应体由后台线程逐块生产，连接以chunked编码边生产边发送（content被忽略）
+        std::shared_ptr<HttpBodyStream> bodyStream;
+        // 非空时响应体为已打开文件的[fileOffset, fileOffset + fileLength)区间，
+        // 由连接直接从文件发送（sendfile或内存映射），不读入content
+        std::shared_ptr<QFile> file;
+        qint64 fileOffset = 0;
+        qint64 fileLength = 0;
     };
 
+    // 请求体限制：在读取请求体之前按请求头检查，超限或类型不符时立即拒绝
+    struct BodyPolicy {
+        // 请求体大小上限，<0时使用连接的默认上限
+        qint64 maxBodySize = -1;
+        // 允许的Content-Type（忽略参数部分，不区分大小写），为空表示不限
+        QStringList contentTypes;
+        // 请求体直接写入临时文件（文件上传），而不是保存在内存中
+        bool streamToFile = false;
+        // 上传文件内容必须以此开头（如"%PDF"），为空表示不检查；只对streamToFile的上传有效
+        QByteArray magic;
+    };
+
+    // 路径参数：{name}占位符 -> 匹配到的路径段
+    using PathParams = QMap<QString, QString>;
+    // 路由处理函数，路径参数与请求分开传入，匹配路由时不必复制请求
+    using RouteHandler = std::function<HttpResponse(const HttpRequest&, const PathParams&)>;
+    // 中间件链中的下一环
+    using NextHandler = std::function<HttpResponse(const HttpRequest&)>;
+    // 中间件：可在调用next之前短路返回，或在之后修改响应
+    using Middleware = std::function<HttpResponse(const HttpRequest&, const NextHandler& next)>;
+
     explicit RequestHandler(DatabaseWorker* dbWorker, QObject* parent = nullptr);
 
+    // 注册路由，pattern中的{name}匹配一个路径段，末尾的{name*}匹配剩余全部路径。
+    // 路由和中间件只能在服务器开始接受连接之前注册
+    void addRoute(const QString& method, const QString& pattern, RouteHandler handler);
+
+    // 注册中间件，按注册顺序由外向内执行
+    void addMiddleware(Middleware middleware);
+
+    // 为已注册的路由设置请求体限制，同样只能在服务器开始接受连接之前调用
+    void setBodyPolicy(const QString& method, const QString& pattern, const BodyPolicy& policy);
+
+    // 设置路由的类别（默认为Default），同样只能在服务器开始接受连接之前调用。
+    // 类别决定准入配额和执行线程池：批量类路由的处理函数由连接放到批量线程池执行，
+    // 不占用工作线程的事件循环
+    void setRouteClass(const QString& method, const QString& pattern,
+                       HttpAdmissionController::RouteClass routeClass);
+
+    // 请求头到达、读取请求体之前调用：declaredBodySize为Content-Length（分块编码时为-1）。
+    // 返回false时rejection为应立即发送的413/415响应；policy和routeClass输出匹配路由的
+    // 请求体限制和类别（未匹配的请求为Default）
+    bool precheckRequest(const HttpRequest& request, qint64 declaredBodySize, BodyPolicy& policy,
+                         HttpAdmissionController::RouteClass& routeClass, HttpResponse& rejection);
+
     // Handle HTTP requests
+    // 返回的响应可能是延迟响应（deferred非空），中间件看到的是尚未执行的响应
     HttpResponse handleRequest(const HttpRequest& request);
+
+    // 构造延迟响应，work在后台线程池执行，不能访问请求对象以外的线程不安全状态
+    static HttpResponse deferResponse(std::function<HttpResponse()> work);
+    // 执行该类别延迟响应（及批量类处理函数）的线程池
+    QThreadPool* deferredPool(HttpAdmissionController::RouteClass routeClass)
+    {
+        return routeClass == HttpAdmissionController::RouteClass::Bulk ? &m_bulkPool : &m_interactivePool;
+    }
     HttpResponse handleSwitchPage(const HttpRequest& request);
     HttpResponse handleBackToMain(const HttpRequest& request);
     HttpResponse handleUploadPDF(const HttpRequest& request);
     HttpResponse handlePDFControl(const HttpRequest& request);
+
     // Register a navigation widget to receive updates
     void registerNavigationWidget(NavigationDisplayWidget* widget);
     
@@ -57,31 +136,88 @@ public:
     // Check if navigation widget is active
     bool isNavigationWidgetActive() const;
     RequestHandler::HttpResponse createErrorResponse(int statusCode, const QString& message);
+
+    // translations表被其他模块直接写入后调用，使/api/data的ETag失效
+    void invalidateDataVersion();
+
+    // /api/media/{path*}提供的文件所在目录，默认为VisionPage保存截图的目录；
+    // 需在服务器开始接受连接之前设置
+    void setMediaRoot(const QString& directory);
+    QString mediaRoot() const { return m_mediaRoot; }
+
+    // 状态变化事件广播（/api/events）
+    EventBroadcaster& eventBroadcaster() { return m_eventBroadcaster; }
+
+    // 当前导航状态，界面直接订阅其changed()信号
+    NavigationStateStore& navigationState() { return m_navigationState; }
+
+    // 界面状态（当前页面、PDF页码等），由MainWindow提供；只能在GUI线程调用uiState()
+    void setUiStateProvider(std::function<QJsonObject()> provider);
+    QJsonObject uiState() const;
    // RequestHandler* getRequestHandler() const { return m_requestHandler; }
 signals:
     // Signal to notify when navigation data is received
     void navigationDataReceived(const QString& direction, const QString& distance);
     void switchPageRequested(int pageIndex);
     void backToMainRequested();
-    void pdfDataReceived(const QByteArray& pdfData);
+    // 上传的PDF已在后台线程打开并检查，文档对象已属于界面线程
+    void pdfDocumentReceived(std::shared_ptr<UploadedPdf> pdf);
     void pdfNextPage();
     void pdfPrevPage();
 private:
     // Database worker
     DatabaseWorker* m_dbWorker;
     
-    // Route handlers map with custom comparator
-    std::map<QRegularExpression, 
-             std::function<HttpResponse(const HttpRequest&)>, 
-             QRegularExpressionCompare> m_routes;
+    // 每个路由的指标，注册路由时创建，请求路径上只做原子更新
+    struct RouteMetrics {
+        MetricHistogram* latency = nullptr;
+        // 按状态码类别计数：1xx..5xx
+        MetricCounter* responses[5] = {};
+        MetricCounter* errors = nullptr;
+    };
+
+    // 编译后的路由表
+    struct Route {
+        QString method;
+        QString pattern;
+        RouteHandler handler;
+        RouteMetrics metrics;
+        BodyPolicy bodyPolicy;
+        HttpAdmissionController::RouteClass routeClass = HttpAdmissionController::RouteClass::Default;
+    };
+    // 路由树节点：静态路径段用哈希表查找，参数段单独保存
+    struct RouteNode {
+        QHash<QString, RouteNode*> children;
+        RouteNode* paramChild = nullptr;
+        QString paramName;
+        bool catchAll = false;
+        // 方法 -> 路由下标
+        QHash<QString, int> routes;
+    };
+    std::vector<Route> m_routes;
+    std::vector<std::unique_ptr<RouteNode>> m_routeNodes;
+    RouteNode* m_routeRoot;
+    // 不含参数的路由：方法 -> (路径 -> 路由下标)，直接一次哈希命中
+    QHash<QString, QHash<QString, int>> m_staticRoutes;
+    std::vector<Middleware> m_middlewares;
+    // 未匹配任何路由的请求
+    RouteMetrics m_unmatchedMetrics;
+
+    static RouteMetrics createRouteMetrics(const QString& method, const QString& route);
+    static void recordRouteMetrics(const RouteMetrics& metrics, int statusCode, qint64 elapsedNs);
+
+    // 查找路由，返回下标，未匹配返回-1；参数写入params
+    int matchRoute(const QString& method, const QString& path, PathParams& params) const;
+    int matchNode(const RouteNode* node, const QList<QStringView>& segments, int index,
+                  const QString& method, PathParams& params) const;
+    HttpResponse runMiddlewares(size_t index, const HttpRequest& request, const PathParams& params,
+                                const RouteHandler& handler) const;
     
     // Navigation widget reference
     NavigationDisplayWidget* m_navigationWidget;
     
     // Latest navigation data
-    QString m_currentDirection;
-    QString m_currentDistance;
-    bool m_navigationActive;
+    NavigationStateStore m_navigationState;
     
     // Request handlers
     HttpResponse handleGetData(const HttpRequest& request);
@@ -94,7 +230,46 @@ private:
     HttpResponse handleRegisterNavigation(const HttpRequest& request);
     HttpResponse handleUnregisterNavigation(const HttpRequest& request);
     HttpResponse handleExecuteSQL(const HttpRequest& request);
-    QMutex m_mutex;
+    HttpResponse handleExportData(const HttpRequest& request);
+    HttpResponse handleEventStream(const HttpRequest& request);
+    HttpResponse handleMetrics(const HttpRequest& request);
+    HttpResponse handleGetMedia(const HttpRequest& request, const PathParams& params);
+    HttpResponse handleGetTrace(const HttpRequest& request);
+    HttpResponse handleSetTraceSampling(const HttpRequest& request);
+
+    // 媒体文件根目录（绝对路径，未规范化，每次请求时规范化后比较）
+    QString m_mediaRoot;
+
+    std::function<QJsonObject()> m_uiStateProvider;
+
+    EventBroadcaster m_eventBroadcaster;
+
+    // 读接口的数据版本，写入时递增，用作ETag
+    std::atomic<quint64> m_dataVersion{1};
+    // 每次启动不同，避免重启后旧ETag与新版本号巧合相同
+    QString m_etagEpoch;
+
+    QString makeETag(const char* kind, quint64 version) const;
+    // If-None-Match是否包含该ETag
+    bool etagMatches(const HttpRequest& request, const QString& etag) const;
+    HttpResponse createNotModifiedResponse(const QString& etag) const;
+
+    // 流式查询响应：在流式线程池中逐批读取结果，以JSON数组片段或NDJSON（每行一个对象）逐块发送
+    HttpResponse createStreamingQueryResponse(const QString& sql, bool ndjson);
+
+    // handleRequest会在多个HTTP工作线程上并发调用，导航相关状态由此锁保护
+    mutable QMutex m_mutex;
+
+    // 最后声明、最先析构：析构时等待仍在执行的延迟响应，其余成员此时仍然有效
+    QThreadPool m_interactivePool;
+    QThreadPool m_bulkPool;
+    // 流式响应的生产方：客户端读得慢时生产方阻塞到连接放弃为止，单独限定线程数，
+    // 慢速下载再多也不会占满批量线程池
+    QThreadPool m_streamPool;
+    // 线程池状态的导出回调，声明在线程池之后、先于线程池析构，/metrics不会访问已销毁的线程池
+    std::vector<MetricCallbackHandle> m_metricCallbacks;
 };
 
+Q_DECLARE_METATYPE(std::shared_ptr<UploadedPdf>)
+
 #endif // REQUESTHANDLER_H
\ No newline at end of file
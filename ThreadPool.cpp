@@ -1,6 +1,7 @@
 #include "ThreadPool.h"
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include "Metrics.h"
 
 // 注册为Qt元对象系统
 static int threadPoolMetaTypeId = qRegisterMetaType<ThreadPool*>("ThreadPool*");
@@ -96,6 +97,19 @@ private:
     QRunnable* m_task;
 };
 
+void ThreadPool::registerMetrics() {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_metricCallbacks.push_back(registry.gaugeCallback(
+        "threadpool_active_threads", "Threads currently running pool tasks", QByteArray(),
+        [this]() { return static_cast<double>(activeThreadCount()); }));
+    m_metricCallbacks.push_back(registry.gaugeCallback(
+        "threadpool_max_threads", "Configured maximum pool threads", QByteArray(),
+        [this]() { return static_cast<double>(threadCount()); }));
+    m_metricCallbacks.push_back(registry.gaugeCallback(
+        "threadpool_queued_tasks", "Tasks submitted but not yet started", QByteArray(),
+        [this]() { return static_cast<double>(queuedTaskCount()); }));
+}
+
 // 添加用于自适应调整线程池大小的方法
 void ThreadPool::adjustThreadCount() {
     int cpuCores = QThread::idealThreadCount();
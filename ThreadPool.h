@@ -11,7 +11,9 @@
 #include <functional>
 #include <atomic>
 #include <QDebug>
+#include <vector>
 #include <opencv2/opencv.hpp>
+#include "Metrics.h"
 // 任务基类
 class Task : public QRunnable {
 public:
@@ -59,14 +61,30 @@ public:
         return QThreadPool::globalInstance()->activeThreadCount();
     }
     
+    // 已提交但尚未开始执行的任务数
+    int queuedTaskCount() const {
+        return m_queuedTasks.load(std::memory_order_relaxed);
+    }
+    
     // 提交任务
     void enqueue(Task* task, int priority = 50) {
-        QThreadPool::globalInstance()->start(task, priority);
+        m_queuedTasks.fetch_add(1, std::memory_order_relaxed);
+        QThreadPool::globalInstance()->start([this, task]() {
+            m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            task->run();
+            if (task->autoDelete()) {
+                delete task;
+            }
+        }, priority);
     }
     
     // 提交函数作为任务
     void enqueue(std::function<void()> function) {
-        QThreadPool::globalInstance()->start(new FunctionTask(function));
+        m_queuedTasks.fetch_add(1, std::memory_order_relaxed);
+        QThreadPool::globalInstance()->start([this, function]() {
+            m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            function();
+        });
     }
     
     // 等待所有任务完成
@@ -96,9 +114,13 @@ private:
                  
         // 设置线程过期时间
         QThreadPool::globalInstance()->setExpiryTimeout(30000); // 30秒线程过期时间
+
+        registerMetrics();
     }
     
     ~ThreadPool() {
+        // 先撤销导出回调，之后的/metrics不再访问本对象
+        m_metricCallbacks.clear();
         QThreadPool::globalInstance()->waitForDone();
         qDebug() << "线程池已销毁";
     }
@@ -106,6 +128,12 @@ private:
     // 禁止复制和赋值
     ThreadPool(const ThreadPool&) = delete;
     ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::atomic<int> m_queuedTasks{0};
+
+    // 向/metrics导出线程池状态，凭据在析构时释放
+    void registerMetrics();
+    std::vector<MetricCallbackHandle> m_metricCallbacks;
 };
 
 // 图像处理任务类
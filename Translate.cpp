@@ -1010,6 +1010,7 @@ void TranslatePage::saveToDatabase()
         qDebug() << "成功保存到 MySQL 数据库，ID:" << query.lastInsertId().toInt() 
                  << "，原文长度:" << recognizedText.length() 
                  << "，翻译长度:" << translatedText.length();
+        emit translationSaved();
     }
 }
 
@@ -36,6 +36,8 @@ public:
 
 signals:
     void backButtonClicked();
+    // 翻译记录已写入translations表
+    void translationSaved();
 
 public slots:
     void onRecordButtonClicked();
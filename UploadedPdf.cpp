@@ -0,0 +1,185 @@
+#include "UploadedPdf.h"
+#include <QPdfDocument>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+// startxref及文件尾的检查范围，规范要求%%EOF位于最后1024字节内，留出余量
+const qint64 kTrailerWindow = 2048;
+
+inline bool isPdfSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\0';
+}
+
+// 从pos开始跳过空白读取一个十进制整数，失败返回-1
+qint64 readNumber(const QByteArray& data, int& pos)
+{
+    while (pos < data.size() && isPdfSpace(data.at(pos))) {
+        ++pos;
+    }
+    const int start = pos;
+    qint64 value = 0;
+    while (pos < data.size() && data.at(pos) >= '0' && data.at(pos) <= '9' && pos - start < 18) {
+        value = value * 10 + (data.at(pos) - '0');
+        ++pos;
+    }
+    return pos > start ? value : -1;
+}
+
+// 是否以"N G obj"开头（交叉引用流对象）
+bool startsWithObjectHeader(const QByteArray& data)
+{
+    int pos = 0;
+    if (readNumber(data, pos) < 0 || readNumber(data, pos) < 0) {
+        return false;
+    }
+    while (pos < data.size() && isPdfSpace(data.at(pos))) {
+        ++pos;
+    }
+    return data.mid(pos, 3) == "obj";
+}
+
+QString loadErrorMessage(QPdfDocument::Error error)
+{
+    switch (error) {
+    case QPdfDocument::Error::IncorrectPassword:
+        return "PDF is password protected";
+    case QPdfDocument::Error::UnsupportedSecurityScheme:
+        return "Unsupported PDF security scheme";
+    case QPdfDocument::Error::InvalidFileFormat:
+        return "Invalid or damaged PDF file";
+    default:
+        return "Failed to open PDF file";
+    }
+}
+}
+
+std::shared_ptr<UploadedPdf> UploadedPdf::open(std::shared_ptr<QTemporaryFile> file, QString& error)
+{
+    if (!file || file->size() == 0) {
+        error = "PDF data is empty";
+        return nullptr;
+    }
+
+    std::shared_ptr<UploadedPdf> pdf(new UploadedPdf());
+    pdf->m_file = file;
+    pdf->m_fileSize = file->size();
+
+    // 内存映射上传的临时文件，PDFium按需读取页面数据，不整体复制到内存
+    const uchar* mapped = file->map(0, pdf->m_fileSize);
+    const QByteArray data = mapped
+        ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), pdf->m_fileSize)
+        : QByteArray();
+
+    // 文件头不对时不必交给PDFium
+    file->seek(0);
+    const QByteArray magic = mapped ? data.left(5) : file->read(5);
+    if (magic != "%PDF-") {
+        qWarning() << "上传的数据不是PDF格式，前5字节:" << magic.toHex();
+        error = "Not a PDF file";
+        return nullptr;
+    }
+
+    pdf->inspectTrailer();
+
+    pdf->m_document = new QPdfDocument();
+    if (mapped) {
+        // 缓冲区随文档一起移动线程和释放
+        QBuffer* buffer = new QBuffer(pdf->m_document);
+        buffer->setData(data);
+        buffer->open(QIODevice::ReadOnly);
+        pdf->m_document->load(buffer);
+    } else {
+        qWarning() << "无法映射PDF文件，改为直接读取:" << file->errorString();
+        pdf->m_document->load(file->fileName());
+    }
+
+    if (pdf->m_document->status() != QPdfDocument::Status::Ready) {
+        error = loadErrorMessage(pdf->m_document->error());
+        qWarning() << "PDF打开失败:" << error;
+        return nullptr;
+    }
+
+    const int pageCount = pdf->m_document->pageCount();
+    if (pageCount <= 0) {
+        error = "PDF has no pages";
+        return nullptr;
+    }
+
+    pdf->m_pageSizes.reserve(pageCount);
+    for (int i = 0; i < pageCount; ++i) {
+        pdf->m_pageSizes.append(pdf->m_document->pagePointSize(i));
+    }
+    pdf->m_title = pdf->m_document->metaData(QPdfDocument::MetaDataField::Title).toString();
+
+    if (pdf->m_xrefDamaged) {
+        qWarning() << "PDF交叉引用表损坏，已由PDFium重建:" << file->fileName();
+    }
+    qDebug() << "PDF检查完成，页数:" << pageCount << "加密:" << pdf->m_encrypted
+             << "大小:" << pdf->m_fileSize << "字节";
+
+    // 此后文档只在界面线程使用
+    if (QCoreApplication* app = QCoreApplication::instance()) {
+        pdf->m_document->moveToThread(app->thread());
+    }
+    return pdf;
+}
+
+UploadedPdf::~UploadedPdf()
+{
+    if (!m_document) {
+        return;
+    }
+
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!app || m_document->thread() == QThread::currentThread()) {
+        // 先关闭文档，文件映射随后随m_file释放
+        delete m_document;
+        return;
+    }
+
+    // 在文档所属的界面线程释放；回调持有文件，文档关闭前映射一直有效
+    QPdfDocument* document = m_document;
+    QMetaObject::invokeMethod(app, [document, file = m_file]() {
+        delete document;
+    }, Qt::QueuedConnection);
+}
+
+void UploadedPdf::inspectTrailer()
+{
+    auto readRange = [this](qint64 offset, qint64 length) {
+        m_file->seek(offset);
+        return m_file->read(length);
+    };
+
+    const qint64 tailLength = qMin(m_fileSize, kTrailerWindow);
+    const QByteArray tail = readRange(m_fileSize - tailLength, tailLength);
+
+    int pos = tail.lastIndexOf("startxref");
+    if (pos < 0) {
+        m_xrefDamaged = true;
+        m_encrypted = tail.contains("/Encrypt");
+        return;
+    }
+    pos += 9;
+    const qint64 xrefOffset = readNumber(tail, pos);
+    if (xrefOffset <= 0 || xrefOffset >= m_fileSize) {
+        m_xrefDamaged = true;
+        m_encrypted = tail.contains("/Encrypt");
+        return;
+    }
+
+    // 传统交叉引用表的trailer字典在文件尾；交叉引用流的字典在流对象开头
+    const QByteArray section = readRange(xrefOffset, qMin(m_fileSize - xrefOffset, kTrailerWindow));
+    if (section.startsWith("xref")) {
+        m_encrypted = tail.contains("/Encrypt");
+    } else if (startsWithObjectHeader(section) && section.contains("/XRef")) {
+        m_encrypted = section.contains("/Encrypt");
+    } else {
+        m_xrefDamaged = true;
+        m_encrypted = tail.contains("/Encrypt");
+    }
+}
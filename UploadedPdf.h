@@ -0,0 +1,61 @@
+#ifndef UPLOADEDPDF_H
+#define UPLOADEDPDF_H
+
+#include <QList>
+#include <QSizeF>
+#include <QString>
+#include <QTemporaryFile>
+#include <memory>
+
+class QPdfDocument;
+
+// 上传的PDF：在处理上传请求的后台线程中打开并检查（页数、页面尺寸、加密、交叉引用表），
+// 打开好的文档随后移到界面线程交给PDFViewerPage直接使用，不再重复解析。
+// 文档以内存映射方式读取上传的临时文件，文档存在期间保持映射
+class UploadedPdf
+{
+public:
+    // 打开并检查文件，文件无效时返回空指针，error为可返回给客户端的原因
+    static std::shared_ptr<UploadedPdf> open(std::shared_ptr<QTemporaryFile> file, QString& error);
+
+    ~UploadedPdf();
+
+    UploadedPdf(const UploadedPdf&) = delete;
+    UploadedPdf& operator=(const UploadedPdf&) = delete;
+
+    // 文档对象属于界面线程，只能在界面线程使用
+    QPdfDocument* document() const { return m_document; }
+    // 交出文档的所有权；接收方须在本对象（持有文件映射）释放之前删除文档
+    QPdfDocument* takeDocument()
+    {
+        QPdfDocument* document = m_document;
+        m_document = nullptr;
+        return document;
+    }
+
+    qint64 fileSize() const { return m_fileSize; }
+    int pageCount() const { return m_pageSizes.size(); }
+    // 各页尺寸，单位为点（1/72英寸）
+    const QList<QSizeF>& pageSizes() const { return m_pageSizes; }
+    QString title() const { return m_title; }
+    // 设置了权限密码（无需密码即可打开）的文档
+    bool encrypted() const { return m_encrypted; }
+    // startxref不指向有效的交叉引用表，文档由PDFium重建后打开
+    bool xrefDamaged() const { return m_xrefDamaged; }
+
+private:
+    UploadedPdf() = default;
+
+    // 检查文件尾部的startxref及其指向的交叉引用表，同时查找加密字典
+    void inspectTrailer();
+
+    std::shared_ptr<QTemporaryFile> m_file;
+    QPdfDocument* m_document = nullptr;
+    qint64 m_fileSize = 0;
+    QList<QSizeF> m_pageSizes;
+    QString m_title;
+    bool m_encrypted = false;
+    bool m_xrefDamaged = false;
+};
+
+#endif // UPLOADEDPDF_H
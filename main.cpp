@@ -10,6 +10,7 @@
 #include <QRandomGenerator>
 #include <QFile>
 #include "CameraResourceManager.h"  // 添加中央摄像头管理器
+#include "AsyncLogger.h"
 
 // 安全的摄像头初始化函数
 void safeInitializeCamera()
@@ -54,6 +55,9 @@ void safeInitializeCamera()
 int main(int argc, char *argv[]) {
     
     QApplication app(argc, argv);
+
+    // 日志改由后台线程写出，帧处理和HTTP线程上的qDebug不再阻塞在终端I/O上
+    AsyncLogger::instance().start(AsyncLogger::Options());
     
     // Create main window
     MainWindow window;
@@ -106,6 +110,11 @@ int main(int argc, char *argv[]) {
             qDebug() << "  - " << address.toString() << (address.protocol() == QAbstractSocket::IPv4Protocol ? " (IPv4)" : " (IPv6)");
         }
         
+        // 遥控器/手机应用的持久控制连接
+        if (server.startControlChannel(8081)) {
+            qDebug() << "控制通道地址: ws://" << ipAddress << ":8081";
+        }
+        
         // 尝试测试数据库连接
         QJsonArray testQuery = dbWorker.queryData("SELECT 1 AS test");
         if (!testQuery.isEmpty()) {
@@ -123,5 +132,7 @@ int main(int argc, char *argv[]) {
                           Qt::WindowMinMaxButtonsHint);
     window.showNormal();
 
-    return app.exec();
+    int result = app.exec();
+    AsyncLogger::instance().stop();
+    return result;
 }
\ No newline at end of file